@@ -0,0 +1,258 @@
+#include "AIDriverBatch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../Shared Files/CarPhysics.h"
+#include "../Shared Files/FastMath.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NMG_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NMG_SIMD_SSE2
+#endif
+
+// A thin layer over the instruction set so that the kernel below is written once. Every wrapper
+// mirrors an operation in fast_math so all three builds agree with the scalar code
+namespace
+{
+#if defined(NMG_SIMD_AVX2)
+	using Float = __m256;
+	constexpr int LANE_WIDTH = 8;
+
+	inline Float set(const float v) { return _mm256_set1_ps(v); }
+	inline Float load(const float* p) { return _mm256_load_ps(p); }
+	inline void store(float* p, const Float v) { _mm256_store_ps(p, v); }
+	inline Float add(const Float a, const Float b) { return _mm256_add_ps(a, b); }
+	inline Float sub(const Float a, const Float b) { return _mm256_sub_ps(a, b); }
+	inline Float mul(const Float a, const Float b) { return _mm256_mul_ps(a, b); }
+	inline Float less(const Float a, const Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	inline Float greater(const Float a, const Float b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	inline Float select(const Float mask, const Float a, const Float b) { return _mm256_blendv_ps(b, a, mask); }
+	inline Float mask_and(const Float mask, const Float a) { return _mm256_and_ps(mask, a); }
+	inline Float round(const Float v) { return _mm256_round_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+#elif defined(NMG_SIMD_SSE2)
+	using Float = __m128;
+	constexpr int LANE_WIDTH = 4;
+
+	inline Float set(const float v) { return _mm_set1_ps(v); }
+	inline Float load(const float* p) { return _mm_load_ps(p); }
+	inline void store(float* p, const Float v) { _mm_store_ps(p, v); }
+	inline Float add(const Float a, const Float b) { return _mm_add_ps(a, b); }
+	inline Float sub(const Float a, const Float b) { return _mm_sub_ps(a, b); }
+	inline Float mul(const Float a, const Float b) { return _mm_mul_ps(a, b); }
+	inline Float less(const Float a, const Float b) { return _mm_cmplt_ps(a, b); }
+	inline Float greater(const Float a, const Float b) { return _mm_cmpgt_ps(a, b); }
+	inline Float select(const Float mask, const Float a, const Float b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+	inline Float mask_and(const Float mask, const Float a) { return _mm_and_ps(mask, a); }
+	// Converting uses the default round-to-nearest-even mode, the same as std::nearbyint
+	inline Float round(const Float v) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(v)); }
+#else
+	// Scalar fallback, each "lane" is a single float and masks are plain bools stored as floats
+	using Float = float;
+	constexpr int LANE_WIDTH = 1;
+
+	inline Float set(const float v) { return v; }
+	inline Float load(const float* p) { return *p; }
+	inline void store(float* p, const Float v) { *p = v; }
+	inline Float add(const Float a, const Float b) { return a + b; }
+	inline Float sub(const Float a, const Float b) { return a - b; }
+	inline Float mul(const Float a, const Float b) { return a * b; }
+	inline Float less(const Float a, const Float b) { return a < b ? 1.f : 0.f; }
+	inline Float greater(const Float a, const Float b) { return a > b ? 1.f : 0.f; }
+	inline Float select(const Float mask, const Float a, const Float b) { return mask != 0.f ? a : b; }
+	inline Float mask_and(const Float mask, const Float a) { return mask != 0.f ? a : 0.f; }
+	inline Float round(const Float v) { return std::nearbyint(v); }
+#endif
+
+	static_assert(CarStateStore::k_lanePadding % LANE_WIDTH == 0, "The store padding must fit whole SIMD lanes");
+
+	/**
+	 * \brief The SIMD version of fast_math::fast_sin
+	 * \param x The angles in radians
+	 * \return The sine of each angle
+	 */
+	inline Float sin_lanes(const Float x)
+	{
+		Float t = sub(x, mul(round(mul(x, set(fast_math::k_inverseTwoPi))), set(fast_math::k_twoPi)));
+
+		t = select(greater(t, set(fast_math::k_halfPi)), sub(set(fast_math::k_pi), t), t);
+		t = select(less(t, set(-fast_math::k_halfPi)), sub(set(-fast_math::k_pi), t), t);
+
+		const Float t2 = mul(t, t);
+		Float polynomial = add(set(fast_math::k_sinC9), mul(t2, set(fast_math::k_sinC11)));
+		polynomial = add(set(fast_math::k_sinC7), mul(t2, polynomial));
+		polynomial = add(set(fast_math::k_sinC5), mul(t2, polynomial));
+		polynomial = add(set(fast_math::k_sinC3), mul(t2, polynomial));
+
+		return add(t, mul(mul(t, t2), polynomial));
+	}
+
+	/**
+	 * \brief The SIMD version of fast_math::fast_cos
+	 * \param x The angles in radians
+	 * \return The cosine of each angle
+	 */
+	inline Float cos_lanes(const Float x)
+	{
+		return sin_lanes(add(x, set(fast_math::k_halfPi)));
+	}
+
+	/**
+	 * \brief Searches the whole racing line, for a car that has only just been handed to the AI
+	 * \param track The track
+	 * \param position Where the car is
+	 * \return The waypoint nearest to the car
+	 */
+	int nearest_waypoint(const TrackAsset& track, const sf::Vector2f& position)
+	{
+		int nearest = 0;
+		float nearestDistance = globals::sqr_magnitude(track.GetRacingLinePoint(0).position - position);
+
+		for (int waypoint = 1; waypoint < track.RacingLinePointCount(); ++waypoint)
+		{
+			const float distance = globals::sqr_magnitude(track.GetRacingLinePoint(waypoint).position - position);
+			if (distance < nearestDistance)
+			{
+				nearest = waypoint;
+				nearestDistance = distance;
+			}
+		}
+
+		return nearest;
+	}
+} // anonymous namespace
+
+AIDriverBatch::AIDriverBatch(const int capacity)
+{
+	const int paddedCapacity = (capacity + CarStateStore::k_lanePadding - 1) / CarStateStore::k_lanePadding * CarStateStore::k_lanePadding;
+
+	m_cars.reserve(capacity);
+	m_x.resize(paddedCapacity, 0.f);
+	m_y.resize(paddedCapacity, 0.f);
+	m_angle.resize(paddedCapacity, 0.f);
+	m_speed.resize(paddedCapacity, 0.f);
+	m_targetX.resize(paddedCapacity, 0.f);
+	m_targetY.resize(paddedCapacity, 0.f);
+}
+
+void AIDriverBatch::Update(CarStateStore& cars, const TrackAsset& track)
+{
+	const int waypointCount = track.RacingLinePointCount();
+	const int lookahead = std::max(1, static_cast<int>(std::lround(globals::game::k_aiLookaheadDistance / track.RacingLineSpacing())));
+
+	// Gather the AI cars into the packed lanes
+	m_cars.clear();
+	for (int car = 0; car < cars.Size(); ++car)
+	{
+		if (!cars.aiDriven[car])
+		{
+			continue;
+		}
+
+		const int lane = static_cast<int>(m_cars.size());
+		const sf::Vector2f position(cars.x[car], cars.y[car]);
+
+		int waypoint = cars.racingLineWaypoint[car];
+		if (waypoint < 0 || waypoint >= waypointCount)
+		{
+			waypoint = nearest_waypoint(track, position);
+		}
+
+		// Move the waypoint on while the next one is nearer. A car moves less than a waypoint's spacing
+		// each step, so this is almost always one comparison
+		for (int i = 0; i < waypointCount; ++i)
+		{
+			const int next = (waypoint + 1) % waypointCount;
+			if (globals::sqr_magnitude(track.GetRacingLinePoint(next).position - position) > globals::sqr_magnitude(track.GetRacingLinePoint(waypoint).position - position))
+			{
+				break;
+			}
+			waypoint = next;
+		}
+		cars.racingLineWaypoint[car] = waypoint;
+
+		const sf::Vector2f& target = track.GetRacingLinePoint((waypoint + lookahead) % waypointCount).position;
+
+		m_x[lane] = position.x;
+		m_y[lane] = position.y;
+		m_angle[lane] = cars.angle[car];
+		m_speed[lane] = std::min(cars.speed[car], track.GetRacingLinePoint(waypoint).targetSpeed);
+		m_targetX[lane] = target.x;
+		m_targetY[lane] = target.y;
+
+		m_cars.push_back(car);
+	}
+
+	const int count = static_cast<int>(m_cars.size());
+	if (count == 0)
+	{
+		return;
+	}
+
+	// The same constants car_physics::step uses, worked out the same way
+	const float turnPerStep = globals::cars::k_carTurnSpeed * car_physics::k_fixedStep;
+	const Float turn = set(turnPerStep);
+	const Float negativeTurn = set(-turnPerStep);
+	const Float time = set(car_physics::k_fixedStep);
+	const Float zero = set(0.f);
+	const Float screenWidth = set(static_cast<float>(globals::game::k_screenWidth));
+	const Float screenHeight = set(static_cast<float>(globals::game::k_screenHeight));
+
+	// Within half a turn of dead ahead, turning would overshoot, so the car drives straight on instead
+	// of weaving from side to side. The turn is small enough to use the angle in place of its sine
+	const Float deadZoneSquared = set(turnPerStep * turnPerStep * 0.25f);
+
+	// The lanes past count hold leftovers from earlier updates, their results are ignored
+	for (int lane = 0; lane < count; lane += LANE_WIDTH)
+	{
+		Float x = load(&m_x[lane]);
+		Float y = load(&m_y[lane]);
+		Float angle = load(&m_angle[lane]);
+		const Float speed = load(&m_speed[lane]);
+		const Float targetX = load(&m_targetX[lane]);
+		const Float targetY = load(&m_targetY[lane]);
+
+		// The sign of sin(angle - bearing) says which way to turn, and it expands to a cross product
+		// of the heading and the direction to the target so no atan2 is needed. The dot product says
+		// whether the target is in front
+		const Float dx = sub(targetX, x);
+		const Float dy = sub(targetY, y);
+		const Float sine = sin_lanes(angle);
+		const Float cosine = cos_lanes(angle);
+		const Float cross = sub(sub(zero, mul(sine, dy)), mul(cosine, dx));
+		const Float dot = sub(mul(sine, dx), mul(cosine, dy));
+
+		const Float distanceSquared = add(mul(dx, dx), mul(dy, dy));
+		const Float straightOn = mask_and(greater(dot, zero), less(mul(cross, cross), mul(deadZoneSquared, distanceSquared)));
+
+		angle = select(straightOn, angle, add(angle, select(less(cross, zero), turn, negativeTurn)));
+
+		// Move forwards along the new heading
+		const Float distance = mul(speed, time);
+		x = add(x, mul(sin_lanes(angle), distance));
+		y = sub(y, mul(cos_lanes(angle), distance));
+
+		// Keep the cars on the screen, with selects rather than min and max so -0 stays -0
+		x = select(less(x, zero), zero, x);
+		x = select(greater(x, screenWidth), screenWidth, x);
+		y = select(less(y, zero), zero, y);
+		y = select(greater(y, screenHeight), screenHeight, y);
+
+		store(&m_x[lane], x);
+		store(&m_y[lane], y);
+		store(&m_angle[lane], angle);
+	}
+
+	// Scatter the results back into the store
+	for (int lane = 0; lane < count; ++lane)
+	{
+		const int car = m_cars[lane];
+
+		cars.x[car] = m_x[lane];
+		cars.y[car] = m_y[lane];
+		cars.angle[car] = m_angle[lane];
+	}
+}
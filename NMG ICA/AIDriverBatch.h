@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+
+#include "AlignedAllocator.h"
+#include "CarStateStore.h"
+#include "../Shared Files/TrackAsset.h"
+
+/**
+ * \brief Updates every AI controlled car in a race together. The AI follows the racing line baked
+ * into the track with a pure pursuit controller: each car remembers the waypoint it is nearest to,
+ * moves it on as the car drives past, and steers towards the waypoint a fixed distance further on.
+ * Looking up the target is O(1) per car and needs no trigonometry. The AI cars are gathered out of the
+ * CarStateStore into packed scratch arrays, steered and moved with SIMD (AVX2, SSE2 or a scalar
+ * fallback, chosen at compile time) and then scattered back. The movement is car_physics::step done
+ * lane by lane, so an AI car moves bit-for-bit the same as a player would with the same controls.
+ * Broadcasting the new positions is left to the caller so the network work happens in its own phase
+ */
+class AIDriverBatch
+{
+public:
+	/**
+	 * \param capacity The most cars that can be AI controlled at once
+	 */
+	explicit AIDriverBatch(int capacity);
+
+	/**
+	 * \brief Steers every AI driven car towards the racing line ahead of it and moves it by one fixed
+	 * physics step, no faster than the racing line's target speed
+	 * \param cars The cars in the race, the AI driven ones are updated
+	 * \param track The track, whose racing line the AI follows
+	 */
+	void Update(CarStateStore& cars, const TrackAsset& track);
+
+	/**
+	 * \return The cars that were moved by the last call to Update
+	 */
+	[[nodiscard]] const std::vector<int>& MovedCars() const { return m_cars; }
+
+private:
+	// The index of each gathered car in the CarStateStore
+	std::vector<int> m_cars;
+
+	// The gathered state, one lane per AI car
+	AlignedVector<float> m_x;
+	AlignedVector<float> m_y;
+	AlignedVector<float> m_angle;
+	AlignedVector<float> m_speed;
+
+	// The point on the racing line each lane is steering towards
+	AlignedVector<float> m_targetX;
+	AlignedVector<float> m_targetY;
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <vector>
+
+/**
+ * \brief A minimal allocator that hands out memory aligned to the given boundary, so that
+ * arrays can be loaded with aligned SIMD instructions and start on a cache line
+ * \tparam T The type being allocated
+ * \tparam Alignment The alignment in bytes, must be a power of two
+ */
+template<typename T, size_t Alignment>
+struct AlignedAllocator
+{
+	using value_type = T;
+
+	template<typename U>
+	struct rebind
+	{
+		using other = AlignedAllocator<U, Alignment>;
+	};
+
+	AlignedAllocator() noexcept = default;
+
+	template<typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept
+	{
+	}
+
+	T* allocate(const size_t count)
+	{
+		return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+	}
+
+	void deallocate(T* pointer, size_t) noexcept
+	{
+		::operator delete(pointer, std::align_val_t(Alignment));
+	}
+
+	template<typename U>
+	bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept
+	{
+		return true;
+	}
+
+	template<typename U>
+	bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept
+	{
+		return false;
+	}
+};
+
+// Wide enough for an AVX register and half a cache line
+constexpr size_t k_simdAlignment = 32;
+
+template<typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T, k_simdAlignment>>;
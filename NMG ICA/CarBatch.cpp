@@ -0,0 +1,237 @@
+#include "CarBatch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Globals.h"
+#include "../Shared Files/Logger.h"
+
+namespace
+{
+	// The size of the names above the cars
+	constexpr unsigned LABEL_CHARACTER_SIZE = 15;
+
+	// The gap between the bottom of a name and the middle of its car
+	constexpr float LABEL_GAP = 30.f;
+
+	/**
+	 * \brief Writes a textured rectangle as two triangles
+	 * \param vertices Where to write the six vertices
+	 * \param corners The corners of the rectangle, clockwise from the top left
+	 * \param texture The area of the atlas to draw
+	 * \param colour The colour to tint the rectangle
+	 */
+	void write_quad(sf::Vertex* vertices, const sf::Vector2f corners[4], const sf::FloatRect& texture, const sf::Color& colour)
+	{
+		const sf::Vector2f textureCorners[4]{
+			{ texture.left, texture.top },
+			{ texture.left + texture.width, texture.top },
+			{ texture.left + texture.width, texture.top + texture.height },
+			{ texture.left, texture.top + texture.height }
+		};
+
+		constexpr int TRIANGLE_CORNERS[6]{ 0, 1, 2, 0, 2, 3 };
+		for (int i = 0; i < 6; ++i)
+		{
+			vertices[i] = sf::Vertex(corners[TRIANGLE_CORNERS[i]], colour, textureCorners[TRIANGLE_CORNERS[i]]);
+		}
+	}
+} // anonymous namespace
+
+CarBatch::CarBatch() :
+	m_carTexture(nullptr),
+	m_font(nullptr),
+	m_atlasReady(false),
+	m_glyphPageTop(0.f),
+	m_labelRevision(0),
+	m_labelsStale(true),
+	m_vertices(sf::Triangles)
+{
+}
+
+void CarBatch::SetCarTexture(const sf::Texture& texture)
+{
+	m_carTexture = &texture;
+	m_labelsStale = true;
+}
+
+void CarBatch::SetFont(const sf::Font& font)
+{
+	m_font = &font;
+	m_labelsStale = true;
+}
+
+void CarBatch::Update(const RenderSnapshot& snapshot)
+{
+	if (m_labelsStale || m_labelRevision != snapshot.labelRevision)
+	{
+		RebuildLabels(snapshot);
+	}
+
+	const int carCount = static_cast<int>(snapshot.cars.size());
+	const size_t carVertices = snapshot.cars.size() * 6;
+	m_vertices.resize(m_labelVertices.size() + carVertices);
+
+	const sf::FloatRect carTexture(0.f, 0.f, globals::cars::k_carSpriteWidth, globals::cars::k_carSpriteHeight);
+
+	size_t vertex = 0;
+	for (int i = 0; i < carCount; ++i)
+	{
+		const CarSnapshot& car = snapshot.cars[i];
+		const sf::Vector2f position = car.position;
+
+		// The label goes underneath its car so that the cars are drawn on top
+		for (int label = m_labelStarts[i]; label < m_labelStarts[i + 1]; ++label)
+		{
+			sf::Vertex& labelVertex = m_vertices[vertex++];
+			labelVertex = m_labelVertices[label];
+			labelVertex.position += position;
+		}
+
+		// Rotate the corners of the car around its origin, the same as an sf::Sprite would
+		const float sine = std::sin(car.angle);
+		const float cosine = std::cos(car.angle);
+		const float left = -globals::cars::k_carOriginX;
+		const float top = -globals::cars::k_carOriginY;
+		const float right = left + globals::cars::k_carSpriteWidth;
+		const float bottom = top + globals::cars::k_carSpriteHeight;
+
+		const sf::Vector2f localCorners[4]{ { left, top }, { right, top }, { right, bottom }, { left, bottom } };
+		sf::Vector2f corners[4];
+		for (int corner = 0; corner < 4; ++corner)
+		{
+			corners[corner] = position + sf::Vector2f(
+				localCorners[corner].x * cosine - localCorners[corner].y * sine,
+				localCorners[corner].x * sine + localCorners[corner].y * cosine
+			);
+		}
+
+		write_quad(&m_vertices[vertex], corners, carTexture, car.colour);
+		vertex += 6;
+	}
+}
+
+void CarBatch::Render(sf::RenderTarget& target) const
+{
+	if (!m_atlasReady)
+	{
+		return;
+	}
+
+	target.draw(m_vertices, sf::RenderStates(&m_atlas.getTexture()));
+}
+
+void CarBatch::RebuildLabels(const RenderSnapshot& snapshot)
+{
+	const int carCount = static_cast<int>(snapshot.cars.size());
+
+	m_labelRevision = snapshot.labelRevision;
+	m_labelsStale = false;
+	m_labelVertices.clear();
+	m_labelStarts.assign(1, 0);
+
+	if (!m_carTexture || !m_font)
+	{
+		m_labelStarts.resize(carCount + 1, 0);
+		m_atlasReady = false;
+		return;
+	}
+
+	// Lay out every name first, so the font has loaded all of the glyphs before its page is copied
+	struct PlacedGlyph
+	{
+		sf::Vector2f corners[4];
+		sf::IntRect textureRect;
+	};
+	std::vector<std::vector<PlacedGlyph>> labels(carCount);
+
+	for (int i = 0; i < carCount; ++i)
+	{
+		const std::string& username = snapshot.usernames[i];
+
+		// The same layout as sf::Text, the baseline sits one character size down
+		float x = 0.f;
+		const float y = static_cast<float>(LABEL_CHARACTER_SIZE);
+		sf::Uint32 previous = 0;
+
+		sf::Vector2f minimum(0.f, 0.f);
+		sf::Vector2f maximum(0.f, 0.f);
+
+		for (const unsigned char character : username)
+		{
+			x += m_font->getKerning(previous, character, LABEL_CHARACTER_SIZE);
+			previous = character;
+
+			const sf::Glyph& glyph = m_font->getGlyph(character, LABEL_CHARACTER_SIZE, false);
+
+			const float left = x + glyph.bounds.left;
+			const float top = y + glyph.bounds.top;
+			const float right = left + glyph.bounds.width;
+			const float bottom = top + glyph.bounds.height;
+
+			labels[i].push_back({ { { left, top }, { right, top }, { right, bottom }, { left, bottom } }, glyph.textureRect });
+
+			minimum = labels[i].size() == 1 ? sf::Vector2f(left, top) : sf::Vector2f(std::min(minimum.x, left), std::min(minimum.y, top));
+			maximum = labels[i].size() == 1 ? sf::Vector2f(right, bottom) : sf::Vector2f(std::max(maximum.x, right), std::max(maximum.y, bottom));
+
+			x += glyph.advance;
+		}
+
+		// Centre the name above the car
+		const sf::Vector2f offset(-(maximum.x - minimum.x) / 2.f, -(maximum.y - minimum.y) - LABEL_GAP);
+		for (auto& placed : labels[i])
+		{
+			for (auto& corner : placed.corners)
+			{
+				corner += offset;
+			}
+		}
+	}
+
+	// Copy the car and the glyph page into the atlas, without blending so the alpha is kept as it is
+	const sf::Vector2u carSize = m_carTexture->getSize();
+	const sf::Texture& glyphPage = m_font->getTexture(LABEL_CHARACTER_SIZE);
+	const sf::Vector2u pageSize = glyphPage.getSize();
+
+	m_glyphPageTop = static_cast<float>(carSize.y + 1);
+	const sf::Vector2u atlasSize(std::max(carSize.x, pageSize.x), carSize.y + 1 + pageSize.y);
+
+	if (m_atlas.getSize() != atlasSize && !m_atlas.create(atlasSize.x, atlasSize.y))
+	{
+		LOG_ERROR("Unable to create a {}x{} texture atlas for the cars", atlasSize.x, atlasSize.y);
+		m_labelStarts.resize(carCount + 1, 0);
+		m_atlasReady = false;
+		return;
+	}
+
+	m_atlas.clear(sf::Color::Transparent);
+
+	sf::Sprite car(*m_carTexture);
+	m_atlas.draw(car, sf::RenderStates(sf::BlendNone));
+
+	sf::Sprite page(glyphPage);
+	page.setPosition(0.f, m_glyphPageTop);
+	m_atlas.draw(page, sf::RenderStates(sf::BlendNone));
+
+	m_atlas.display();
+	m_atlasReady = true;
+
+	// Turn the glyphs into vertices, pointing into the glyph page's place in the atlas
+	for (const auto& label : labels)
+	{
+		for (const auto& placed : label)
+		{
+			const sf::FloatRect texture(
+				static_cast<float>(placed.textureRect.left),
+				static_cast<float>(placed.textureRect.top) + m_glyphPageTop,
+				static_cast<float>(placed.textureRect.width),
+				static_cast<float>(placed.textureRect.height)
+			);
+
+			m_labelVertices.resize(m_labelVertices.size() + 6);
+			write_quad(&m_labelVertices[m_labelVertices.size() - 6], placed.corners, texture, sf::Color::White);
+		}
+
+		m_labelStarts.push_back(static_cast<int>(m_labelVertices.size()));
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <SFML/Graphics.hpp>
+
+#include "RenderSnapshot.h"
+
+/**
+ * \brief Draws every car and the name above it in a single draw call. The car texture and the
+ * font's glyphs for the labels are copied into one atlas, and each frame the cars and labels are
+ * written into one vertex array as textured triangles. Laying the labels out is the expensive part,
+ * so it is only done when players join or leave, and each frame just moves the cached label
+ * geometry to where its car is
+ */
+class CarBatch
+{
+public:
+	CarBatch();
+
+	/**
+	 * \param texture The texture of a car, it must outlive the batch
+	 */
+	void SetCarTexture(const sf::Texture& texture);
+
+	/**
+	 * \param font The font to write the names with, it must outlive the batch
+	 */
+	void SetFont(const sf::Font& font);
+
+	/**
+	 * \brief Writes the cars into the vertex array, rebuilding the atlas and the labels first if
+	 * the players have changed since the last update
+	 * \param snapshot The cars to draw and their names
+	 */
+	void Update(const RenderSnapshot& snapshot);
+
+	/**
+	 * \brief Draws the cars and labels written by the last Update
+	 * \param target The target to draw to
+	 */
+	void Render(sf::RenderTarget& target) const;
+
+private:
+	const sf::Texture* m_carTexture;
+	const sf::Font* m_font;
+
+	// The car texture at the top left, with the font's glyph page underneath
+	sf::RenderTexture m_atlas;
+	bool m_atlasReady;
+
+	// Where the font's glyph page starts in the atlas
+	float m_glyphPageTop;
+
+	// The label of every player laid out around the middle of their car, with texture coordinates
+	// into the atlas. The labels are stored one after the other, in the same order as the players
+	std::vector<sf::Vertex> m_labelVertices;
+
+	// Where each player's label starts in m_labelVertices, with one extra entry for the end of the last
+	std::vector<int> m_labelStarts;
+
+	// The RenderSnapshot::labelRevision the labels were laid out for
+	uint32_t m_labelRevision;
+
+	// Whether the labels need laying out again even if the players haven't changed
+	bool m_labelsStale;
+
+	// Every car and label, rewritten each update
+	sf::VertexArray m_vertices;
+
+	/**
+	 * \brief Copies the car texture and the font's glyph page into the atlas and lays out the labels
+	 * \param snapshot The cars to write the names of
+	 */
+	void RebuildLabels(const RenderSnapshot& snapshot);
+};
@@ -0,0 +1,82 @@
+#include "CarHistory.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	constexpr float TWO_PI = 6.28318531f;
+} // anonymous namespace
+
+CarHistory::CarHistory(const int capacity) :
+	m_samples(static_cast<size_t>(capacity) * k_samplesPerCar),
+	m_newest(capacity, 0),
+	m_counts(capacity, 0)
+{
+	static_assert((k_samplesPerCar & k_sampleMask) == 0, "The ring size must be a power of two");
+}
+
+void CarHistory::Reset(const int car, const int64_t time, const sf::Vector2f& position, const float angle)
+{
+	m_counts[car] = 0;
+	Record(car, time, position, angle);
+}
+
+void CarHistory::Record(const int car, const int64_t time, const sf::Vector2f& position, const float angle)
+{
+	int& newest = m_newest[car];
+	int& count = m_counts[car];
+
+	// Several changes in the same moment only keep the last
+	if (count == 0 || time > At(car, newest).time)
+	{
+		newest = (newest + 1) & k_sampleMask;
+		count = std::min(count + 1, k_samplesPerCar);
+	}
+
+	m_samples[car * k_samplesPerCar + newest] = { time, position.x, position.y, angle };
+}
+
+void CarHistory::Remove(const int car, const int movedCar)
+{
+	if (movedCar == -1)
+	{
+		m_counts[car] = 0;
+		return;
+	}
+
+	std::copy_n(m_samples.begin() + movedCar * k_samplesPerCar, k_samplesPerCar, m_samples.begin() + car * k_samplesPerCar);
+	m_newest[car] = m_newest[movedCar];
+	m_counts[car] = m_counts[movedCar];
+	m_counts[movedCar] = 0;
+}
+
+void CarHistory::StateAt(const int car, const int64_t time, sf::Vector2f& position, float& angle) const
+{
+	const int newest = m_newest[car];
+	const int count = m_counts[car];
+
+	// Walk back from the newest state to the first one at or before the time
+	int back = 0;
+	while (back < count - 1 && At(car, newest - back).time > time)
+	{
+		++back;
+	}
+
+	const Sample& before = At(car, newest - back);
+	if (back == 0 || before.time >= time)
+	{
+		position = { before.x, before.y };
+		angle = before.angle;
+		return;
+	}
+
+	const Sample& after = At(car, newest - back + 1);
+	const float t = static_cast<float>(time - before.time) / static_cast<float>(after.time - before.time);
+
+	position = { before.x + (after.x - before.x) * t, before.y + (after.y - before.y) * t };
+
+	// Turn the short way round
+	const float turn = std::remainder(after.angle - before.angle, TWO_PI);
+	angle = before.angle + turn * t;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <SFML/System/Vector2.hpp>
+
+/**
+ * \brief Where every car has been recently, so the server can look at the race the way a client saw
+ * it when it acted. Each car has a fixed ring of timestamped states that is made once and
+ * overwritten oldest first, and looking a car up at a time blends the two states either side of it.
+ * Cars are indexed the same as the CarStateStore and removed the same way
+ */
+class CarHistory
+{
+public:
+	/**
+	 * \param capacity The most cars the history is kept for, the rings never reallocate
+	 */
+	explicit CarHistory(int capacity);
+
+	/**
+	 * \brief Starts a car's history again with a single state, for a car that has just been added
+	 * \param car The index of the car
+	 * \param time When the car was at the state, in microseconds of server time
+	 * \param position The position of the car
+	 * \param angle The angle of the car in radians
+	 */
+	void Reset(int car, int64_t time, const sf::Vector2f& position, float angle);
+
+	/**
+	 * \brief Adds the newest state of a car, overwriting its oldest one if the ring is full. A state
+	 * no newer than the car's newest replaces it, so the ring is always in order
+	 * \param car The index of the car
+	 * \param time When the car was at the state, in microseconds of server time
+	 * \param position The position of the car
+	 * \param angle The angle of the car in radians
+	 */
+	void Record(int car, int64_t time, const sf::Vector2f& position, float angle);
+
+	/**
+	 * \brief Removes a car, mirroring CarStateStore::Remove where the last car is moved into its place
+	 * \param car The index of the car to remove
+	 * \param movedCar The index the moved car used to have, -1 if no car was moved
+	 */
+	void Remove(int car, int movedCar);
+
+	/**
+	 * \brief Works out where a car was at a time, between the states either side of it. Times before
+	 * the oldest state give the oldest state and times after the newest give the newest, the
+	 * history is never extrapolated
+	 * \param car The index of the car
+	 * \param time The time to look at, in microseconds of server time
+	 * \param position Where the car was
+	 * \param angle The angle the car was at in radians
+	 */
+	void StateAt(int car, int64_t time, sf::Vector2f& position, float& angle) const;
+
+private:
+	// The states kept for each car. Cars update at most once per server tick and at least 20 times
+	// a second, so this covers well over globals::lag_compensation::k_maxRewind
+	static constexpr int k_samplesPerCar = 32;
+	static constexpr int k_sampleMask = k_samplesPerCar - 1;
+
+	struct Sample
+	{
+		int64_t time = 0;
+		float x = 0.f;
+		float y = 0.f;
+		float angle = 0.f;
+	};
+
+	// Every car's ring one after the other, car n's ring starts at n * k_samplesPerCar
+	std::vector<Sample> m_samples;
+
+	// The slot of each car's newest state, and how many of its slots are in use
+	std::vector<int> m_newest;
+	std::vector<int> m_counts;
+
+	/**
+	 * \param car The index of a car
+	 * \param slot A slot of the car's ring, wrapped into range
+	 * \return The state in the slot
+	 */
+	[[nodiscard]] const Sample& At(const int car, const int slot) const
+	{
+		return m_samples[car * k_samplesPerCar + (slot & k_sampleMask)];
+	}
+};
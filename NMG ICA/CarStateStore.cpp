@@ -0,0 +1,86 @@
+#include "CarStateStore.h"
+
+#include "../Shared Files/CarPhysics.h"
+
+CarStateStore::CarStateStore(const int capacity) :
+	m_size(0),
+	m_capacity(capacity)
+{
+	// Round up to a full set of lanes, the padding cars are never used but keep SIMD loads in bounds
+	const int paddedCapacity = (capacity + k_lanePadding - 1) / k_lanePadding * k_lanePadding;
+
+	x.resize(paddedCapacity, 0.f);
+	y.resize(paddedCapacity, 0.f);
+	angle.resize(paddedCapacity, 0.f);
+	speed.resize(paddedCapacity, 0.f);
+	lapsCompleted.resize(paddedCapacity, 0);
+	nextCheckPoint.resize(paddedCapacity, 1);
+	progress.resize(paddedCapacity, 0.f);
+	centrelineSegment.resize(paddedCapacity, 0);
+	racingLineWaypoint.resize(paddedCapacity, -1);
+	raceCompleted.resize(paddedCapacity, 0);
+	aiDriven.resize(paddedCapacity, 0);
+	finishTime.resize(paddedCapacity, 0);
+}
+
+int CarStateStore::Add(const sf::Vector2f& position, const float carAngle)
+{
+	if (m_size == m_capacity)
+	{
+		return -1;
+	}
+
+	const int car = m_size++;
+
+	x[car] = position.x;
+	y[car] = position.y;
+	angle[car] = carAngle;
+	speed[car] = globals::cars::k_carTrackSpeed;
+	lapsCompleted[car] = 0;
+	nextCheckPoint[car] = 1;
+	progress[car] = 0.f;
+	centrelineSegment[car] = 0;
+	racingLineWaypoint[car] = -1;
+	raceCompleted[car] = 0;
+	aiDriven[car] = 0;
+	finishTime[car] = 0;
+
+	return car;
+}
+
+int CarStateStore::Remove(const int car)
+{
+	const int last = --m_size;
+
+	if (car == last)
+	{
+		return -1;
+	}
+
+	x[car] = x[last];
+	y[car] = y[last];
+	angle[car] = angle[last];
+	speed[car] = speed[last];
+	lapsCompleted[car] = lapsCompleted[last];
+	nextCheckPoint[car] = nextCheckPoint[last];
+	progress[car] = progress[last];
+	centrelineSegment[car] = centrelineSegment[last];
+	racingLineWaypoint[car] = racingLineWaypoint[last];
+	raceCompleted[car] = raceCompleted[last];
+	aiDriven[car] = aiDriven[last];
+	finishTime[car] = finishTime[last];
+
+	return last;
+}
+
+uint64_t CarStateStore::Hash() const
+{
+	uint64_t hash = car_physics::k_hashSeed;
+	for (int car = 0; car < m_size; ++car)
+	{
+		hash = car_physics::hash_state({ { x[car], y[car] }, angle[car], speed[car] }, hash);
+		hash = car_physics::hash_combine(hash, lapsCompleted[car]);
+		hash = car_physics::hash_combine(hash, nextCheckPoint[car]);
+	}
+	return hash;
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <SFML/System/Vector2.hpp>
+
+#include "AlignedAllocator.h"
+#include "Globals.h"
+
+/**
+ * \brief Holds the per-car simulation state of a race as a structure of arrays. Each field
+ * lives in its own contiguous, aligned array indexed by the car, so the simulation loops
+ * stream through memory instead of chasing pointers. The session data for a car (its username
+ * and socket) is kept separately in the ClientSnapshot
+ */
+struct CarStateStore
+{
+	// The arrays are padded to a multiple of this so SIMD loops can always run full lanes
+	static constexpr int k_lanePadding = 8;
+
+	/**
+	 * \param capacity The most cars the store can hold, the arrays never reallocate
+	 */
+	explicit CarStateStore(int capacity);
+
+	/**
+	 * \brief Adds a new car to the end of the arrays
+	 * \param position The starting position of the car
+	 * \param carAngle The starting angle of the car in radians
+	 * \return The index of the new car, -1 if the store is full
+	 */
+	int Add(const sf::Vector2f& position, float carAngle);
+
+	/**
+	 * \brief Removes a car by moving the last car into its place, so the arrays stay packed
+	 * \param car The index of the car to remove
+	 * \return The index the last car used to have before it was moved into car,
+	 * -1 if no car was moved
+	 */
+	int Remove(int car);
+
+	/**
+	 * \return The amount of cars in the store
+	 */
+	[[nodiscard]] int Size() const { return m_size; }
+
+	/**
+	 * \return The most cars the store can hold
+	 */
+	[[nodiscard]] int Capacity() const { return m_capacity; }
+
+	/**
+	 * \param car The index of the car
+	 * \return The position of the car
+	 */
+	[[nodiscard]] sf::Vector2f Position(const int car) const { return { x[car], y[car] }; }
+
+	/**
+	 * \param car The index of the car
+	 * \param position The new position of the car
+	 */
+	void SetPosition(const int car, const sf::Vector2f& position) { x[car] = position.x; y[car] = position.y; }
+
+	/**
+	 * \brief Hashes the simulation state of every car, so two copies of the race can be compared
+	 * by sending 64 bits instead of the whole state
+	 * \return The hash of the cars
+	 */
+	[[nodiscard]] uint64_t Hash() const;
+
+	// The position of each car
+	AlignedVector<float> x;
+	AlignedVector<float> y;
+
+	// The angle of each car in radians
+	AlignedVector<float> angle;
+
+	// The current speed of each car
+	AlignedVector<float> speed;
+
+	// The amount of laps completed by each car
+	AlignedVector<int32_t> lapsCompleted;
+
+	// The checkpoint each car has to cross next. They are crossed in order from 1 upwards and
+	// checkpoint 0, the finish line, is always last
+	AlignedVector<int32_t> nextCheckPoint;
+
+	// How far each car is through the race, the laps completed times the track length plus the
+	// distance along the track centreline. Frozen once the car finishes
+	AlignedVector<float> progress;
+
+	// The centreline segment each car was nearest to last, used as a hint for the next lookup
+	AlignedVector<int32_t> centrelineSegment;
+
+	// The racing line waypoint each AI controlled car is nearest to, -1 until the AI takes over
+	AlignedVector<int32_t> racingLineWaypoint;
+
+	// Whether each car has finished the race, stored as bytes so it can be streamed
+	AlignedVector<uint8_t> raceCompleted;
+
+	// Whether each car is driven by the server's AI, the bots filling the grid from the start and
+	// the players' cars once they finish
+	AlignedVector<uint8_t> aiDriven;
+
+	// When each car crossed the finish line for the last time as its driver saw it, in microseconds
+	// of server time, so finishers are placed in the order they really crossed
+	AlignedVector<int64_t> finishTime;
+
+private:
+	// The amount of cars in the store
+	int m_size;
+
+	// The most cars the store can hold
+	int m_capacity;
+};
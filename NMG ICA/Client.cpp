@@ -1,15 +1,17 @@
 ﻿#include "Client.h"
 
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include <utility>
 
 #include "Globals.h"
+#include "../Shared Files/Logger.h"
 
-std::unique_ptr<Client> Client::CreateClient(const std::string& username, const unsigned short port)
+std::unique_ptr<Client> Client::CreateClient(const std::string& username, const unsigned short port, const bool spectator)
 {
 	// Create a new client object
-	std::unique_ptr<Client> newClient(new Client(username));
+	std::unique_ptr<Client> newClient(new Client(username, spectator));
 
 	if (newClient->Initialise(port))
 	{
@@ -31,9 +33,19 @@ bool Client::Initialise(const unsigned short port)
 	{
 		return false;
 	}
+	m_renderer.SetCarTexture(m_carTexture);
 
-	// Connect to the server
-	if (m_socket.connect(sf::IpAddress::getLocalAddress(), port) != sf::Socket::Done)
+	// Connect to the server and make first contact, see if the server has confirmed that the
+	// username is available...
+	m_serverPort = port;
+
+	const TcpDataPacket firstConnectionDataPacket(
+		m_spectating ? eDataPacketType::e_SpectatorConnection : eDataPacketType::e_FirstConnection,
+		m_userName
+	);
+
+	TcpDataPacket inDataPacket;
+	if (!Connect(firstConnectionDataPacket, globals::sessions::k_connectionTimeout, inDataPacket))
 	{
 		std::cout << "Unable to connect to the server at address: " << sf::IpAddress::getLocalAddress() << std::endl;
 		return false;
@@ -41,84 +53,235 @@ bool Client::Initialise(const unsigned short port)
 
 	std::cout << m_userName << " connected to server " << sf::IpAddress::getLocalAddress() << std::endl;
 
-	// Now that we've connected, make first contact with the server
+	// See what the server sent back to us
+	switch (inDataPacket.m_type)
+	{
+		// Success...
+	case eDataPacketType::e_UserNameConfirmation:
+		std::cout << "Username confirmed, client connected" << std::endl;
+		JoinRace(inDataPacket);
+		break;
+
+		// The race is on or full, the confirmation comes once the next room has a place
+	case eDataPacketType::e_Queued:
+		std::cout << "Waiting for the next race, number " << inDataPacket.m_positionInRace << " in the queue" << std::endl;
+		break;
+		// Spectators are welcomed with a keyframe of the race
+	case eDataPacketType::e_WorldSnapshot:
+		std::cout << "Spectating the race" << std::endl;
+		ApplyWorldSnapshot(inDataPacket.m_worldSnapshot);
+		break;
+
+		// Failure...
+	case eDataPacketType::e_UserNameRejection:
+		std::cout << "The username is taken, try again" << std::endl;
+		return false;
+
+	case eDataPacketType::e_MaxPlayers:
+		std::cout << "There is no room, try again later" << std::endl;
+		return false;
+	}
+
+	// If everything was set up okay, we have a complete client. From here on the socket belongs
+	// to the network thread
+	m_network.Start(m_socket);
+	return true;
+}
+
+void Client::JoinRace(const TcpDataPacket& confirmation)
+{
+	m_networkId = confirmation.m_networkId;
+	m_resumeToken = confirmation.m_resumeToken;
+	AddPlayer(m_networkId, m_userName);
+
+	Player& player = *m_players.Find(m_networkId);
+
+	player.SetColour(
+		{
+			static_cast<sf::Uint8>(confirmation.m_red),
+			static_cast<sf::Uint8>(confirmation.m_green),
+			static_cast<sf::Uint8>(confirmation.m_blue)
+		}
+	);
+
+	player.SetPosition(
+		{
+			confirmation.m_x,
+			confirmation.m_y
+		}
+	);
+
+	player.SetAngle(confirmation.m_angle);
+}
+
+bool Client::Connect(const TcpDataPacket& greeting, const float timeout, TcpDataPacket& reply)
+{
+	// The socket is non-blocking after the first connection, and has to block to connect with a timeout
+	m_socket.setBlocking(true);
+
+	if (m_socket.connect(sf::IpAddress::getLocalAddress(), m_serverPort, sf::seconds(timeout)) != sf::Socket::Done)
+	{
+		LOG_WARNING("Unable to connect to the server on port {}", static_cast<unsigned>(m_serverPort));
+		return false;
+	}
+
 	sf::Packet outPacket;
-	const TcpDataPacket firstConnectionDataPacket(eDataPacketType::e_FirstConnection, m_userName);
-	outPacket << firstConnectionDataPacket;
+	outPacket << greeting;
 
 	m_socket.send(outPacket);
 
 	// Set the socket to false so it doesn't block the main thread
 	m_socket.setBlocking(false);
 
-
-	// See if the server has confirmed that the username is available...
 	sf::Packet inPacket;
 
+	// Sleep until the server says something rather than asking the socket over and over. The reply
+	// can arrive in pieces, so keep waiting out whatever is left of the timeout until all of it is here
+	sf::SocketSelector replySelector;
+	replySelector.add(m_socket);
+
+	const sf::Time deadline = sf::seconds(timeout);
 	sf::Clock clock{};
-	float elapsedTime = 0.f;
-	while (m_socket.receive(inPacket) != sf::Socket::Done)
+
+	sf::Socket::Status status = sf::Socket::NotReady;
+	while (status != sf::Socket::Done)
 	{
-		elapsedTime += clock.restart().asSeconds();
+		const sf::Time remaining = deadline - clock.getElapsedTime();
 
-		std::cout << " waiting for confirmation " << elapsedTime << std::endl;
+		// So that we're not waiting forever
+		if (remaining <= sf::Time::Zero || !replySelector.wait(remaining))
+		{
+			LOG_WARNING("Timed out waiting for the server to reply");
+			m_socket.disconnect();
+			return false;
+		}
 
-		// So that we're not waiting forever, timeout after 10 seconds
-		if (elapsedTime >= 10.f)
+		status = m_socket.receive(inPacket);
+		if (status == sf::Socket::Disconnected || status == sf::Socket::Error)
 		{
-			std::cout << "Timeout! " << std::endl;
+			LOG_WARNING("The server closed the connection before replying");
+			m_socket.disconnect();
 			return false;
 		}
 	}
 
+	inPacket >> reply;
+	return true;
+}
 
-	// See what the server sent back to us
-	TcpDataPacket inDataPacket;
-	inPacket >> inDataPacket;
+void Client::SyncClock(const float deltaTime)
+{
+	// Spectators only watch, so they never need the server's time
+	if (m_spectating || !m_network.IsConnected())
+	{
+		return;
+	}
 
-	switch (inDataPacket.m_type)
+	m_clockSyncTimer -= deltaTime;
+	if (m_clockSyncTimer > 0.f)
 	{
-		// Success...
-	case eDataPacketType::e_UserNameConfirmation:
-		std::cout << "Username confirmed, client connected" << std::endl;
+		return;
+	}
+	m_clockSyncTimer = globals::sessions::k_clockSyncInterval;
 
-		AddPlayer(m_userName);
+	TcpDataPacket clockRequest(eDataPacketType::e_ClockRequest, m_userName);
+	clockRequest.m_networkId = m_networkId;
+	clockRequest.m_originateTime = network_clock::now();
+	SendMessage(clockRequest);
+}
 
-		m_players[m_userName].SetColour(
-			{
-				static_cast<sf::Uint8>(inDataPacket.m_red),
-				static_cast<sf::Uint8>(inDataPacket.m_green),
-				static_cast<sf::Uint8>(inDataPacket.m_blue)
-			}
-		);
+void Client::CheckConnection(const float deltaTime)
+{
+	// Only a player the server gave a token to has a session to come back to
+	if (m_network.IsConnected() || m_resumeToken == 0)
+	{
+		return;
+	}
 
-		m_players[m_userName].SetPosition(
-			{
-				inDataPacket.m_x,
-				inDataPacket.m_y
-			}
-		);
+	m_disconnectedTime += deltaTime;
+	if (m_disconnectedTime > globals::sessions::k_resumeGracePeriod)
+	{
+		LOG_WARNING("The connection has been down too long, the server will have removed {} from the race", m_userName);
+		m_resumeToken = 0;
+		return;
+	}
 
-		m_players[m_userName].SetAngle(inDataPacket.m_angle);
+	m_resumeTimer -= deltaTime;
+	if (m_resumeTimer > 0.f)
+	{
+		return;
+	}
+	m_resumeTimer = globals::sessions::k_resumeRetryInterval;
 
-		break;
-		// Failure...
-	case eDataPacketType::e_UserNameRejection:
-		std::cout << "The username is taken, try again" << std::endl;
+	if (ResumeSession())
+	{
+		LOG_INFO("Resumed the session after {} seconds", m_disconnectedTime);
+		m_disconnectedTime = 0.f;
+		m_resumeTimer = 0.f;
+	}
+}
+
+bool Client::ResumeSession()
+{
+	LOG_INFO("Trying to resume the session of {}", m_userName);
+
+	// The network thread has stopped, so the socket is ours until it is started again
+	m_network.Stop();
+	m_socket.disconnect();
+
+	TcpDataPacket resumeData(eDataPacketType::e_ResumeSession, m_userName);
+	resumeData.m_networkId = m_networkId;
+	resumeData.m_resumeToken = m_resumeToken;
+
+	// Don't hold up the game thread any longer than the time between attempts
+	TcpDataPacket inDataPacket;
+	if (!Connect(resumeData, globals::sessions::k_resumeRetryInterval, inDataPacket))
+	{
+		return false;
+	}
+
+	if (inDataPacket.m_type != eDataPacketType::e_SessionResumed)
+	{
+		LOG_WARNING("The server wouldn't resume the session of {}", m_userName);
+		m_resumeToken = 0;
+		m_socket.disconnect();
 		return false;
 	}
 
-	// If everything was set up okay, we have a complete client
+	// Catch up with everything that happened while the connection was down
+	m_resumeToken = inDataPacket.m_resumeToken;
+	ApplyWorldSnapshot(inDataPacket.m_worldSnapshot);
+	m_positionInRace = inDataPacket.m_positionInRace;
+
+	if (const WorldCar* car = inDataPacket.m_worldSnapshot.FindCar(m_networkId))
+	{
+		m_lapsCompleted = car->lapsCompleted;
+		m_completedRace = m_lapsCompleted >= globals::game::k_totalLaps;
+	}
+
+	m_network.Start(m_socket);
 	return true;
 }
 
-void Client::Update(const float deltaTime)
+void Client::Update(const float deltaTime, const int physicsSteps)
 {
-	// We only want to send messages to the server if the game is in action
-	if (m_gameStarted && !m_completedRace)
+	CheckConnection(deltaTime);
+	SyncClock(deltaTime);
+
+	// We only want to send messages to the server if the game is in action. While the connection
+	// is down the server holds the car where it was, so the player does too
+	Player* localPlayer = m_players.Find(m_networkId);
+
+	if (m_gameStarted && !m_completedRace && localPlayer && m_network.IsConnected())
 	{
-		m_players[m_userName].Update(deltaTime);
-		m_background.CheckCollisions(m_players[m_userName]);
+		Player& player = *localPlayer;
+
+		// Run the same fixed steps as the server, so the car moves the same at any frame rate
+		for (int step = 0; step < physicsSteps; ++step)
+		{
+			m_background.CheckCollisions(player);
+			player.Update(m_input);
+		}
 
 		m_packetTimer += deltaTime;
 
@@ -130,254 +293,260 @@ void Client::Update(const float deltaTime)
 		}
 	}
 
+	m_input = {};
+
 	// But we want to receive all the time, incase a client connects or disconnects
-	ReceiveMessage();
+	ReceiveMessages();
+
+	PublishSnapshot();
 }
 
-void Client::Render(sf::RenderWindow& window)
+void Client::StartRendering(sf::RenderWindow& window, const ePacingMode mode, const float frameRate)
 {
-	// Reset the text colour in-case it changed
-	m_text.setFillColor(sf::Color::White);
-
-	if (m_gameStarted)
-	{
-		if (m_gameOver)
-		{
-			// Display the final order of the racers
-			for (int i = 0; i < static_cast<int>(m_finalPlayerOrder.size()); ++i)
-			{
-				std::string stringToDisplay;
-				switch (i)
-				{
-				case 0:
-					stringToDisplay = "1st: ";
-					break;
-				case 1:
-					stringToDisplay = "2nd: ";
-					break;
-				case 2:
-					stringToDisplay = "3rd: ";
-					break;
-				case 3:
-					stringToDisplay = "4th: ";
-					break;
-				default:
-					break;
-
-				}
-
-				// Highlight the player with green text
-				m_text.setFillColor(m_finalPlayerOrder[i] == m_userName ? sf::Color::Green : sf::Color::White);
-
-				m_text.setString(stringToDisplay + m_finalPlayerOrder[i]);
-
-				// Offset the text from each other
-				m_text.setPosition(
-					static_cast<float>(globals::game::k_screenWidth) / 2.f - m_text.getGlobalBounds().width / 2,
-					static_cast<float>(globals::game::k_screenHeight) / 2.f + static_cast<float>(i) * m_text.getGlobalBounds().height + 20.f
-				);
-
-				window.draw(m_text);
-			}
-		} else
-		{
-			m_background.Render(window);
-
-			// Structured binding for the players in the map because C++17 is cool
-
-			for (auto& [username, player] : m_players)
-			{
-				// Render username above the player's car
-				m_text.setString(username);
-
-				m_text.setCharacterSize(15);
+	m_renderer.Start(window, m_background, m_snapshots, m_userName, mode, frameRate);
+}
 
-				const sf::Vector2f& playerPosition = player.GetPosition();
+void Client::StopRendering()
+{
+	m_renderer.Stop();
+}
 
-				m_text.setPosition(playerPosition.x - m_text.getGlobalBounds().width / 2, playerPosition.y - m_text.getGlobalBounds().height - 30);
+void Client::PublishSnapshot()
+{
+	RenderSnapshot& snapshot = m_snapshots.WriteBuffer();
 
-				window.draw(m_text);
+	if (!m_gameStarted)
+	{
+		snapshot.phase = eGamePhase::e_Waiting;
+	} else
+	{
+		snapshot.phase = m_gameOver ? eGamePhase::e_Results : eGamePhase::e_Racing;
+	}
 
-				player.Render(window);
-			}
+	snapshot.spectating = m_spectating;
 
-			// Draw the UI last
+	snapshot.cars.resize(m_players.Size());
+	for (int i = 0; i < m_players.Size(); ++i)
+	{
+		const Player& player = m_players.PlayerAt(i);
+		snapshot.cars[i] = { player.GetPosition(), player.GetAngle(), player.GetColour() };
+	}
 
-			m_text.setString("Laps: " + std::to_string(m_lapsCompleted + 1) + " / " + std::to_string(globals::game::k_totalLaps));
+	// The names only change when players join or leave, so they are only copied then
+	if (snapshot.labelRevision != m_players.Revision())
+	{
+		snapshot.usernames.resize(m_players.Size());
+		for (int i = 0; i < m_players.Size(); ++i)
+		{
+			snapshot.usernames[i] = m_players.UsernameAt(i);
+		}
+		snapshot.labelRevision = m_players.Revision();
+	}
 
-			m_text.setCharacterSize(30);
-			m_text.setPosition(730.f, 25.f);
-			window.draw(m_text);
+	snapshot.lapsCompleted = m_lapsCompleted;
+	snapshot.positionInRace = m_positionInRace;
 
-			m_text.setString("Pos: " + std::to_string(m_positionInRace) + " / " + std::to_string(m_players.size()));
-			m_text.setPosition(730.f, 75.f);
-			window.draw(m_text);
-		}
-	} else
+	if (snapshot.placementOrder != m_finalPlayerOrder)
 	{
-		m_text.setPosition(
-			static_cast<float>(globals::game::k_screenWidth) / 2.f - m_text.getGlobalBounds().width / 2,
-			static_cast<float>(globals::game::k_screenHeight) / 2.f - m_text.getGlobalBounds().height
-		);
-
-		window.draw(m_text);
+		snapshot.placementOrder = m_finalPlayerOrder;
 	}
+
+	m_snapshots.Publish();
 }
 
-void Client::Input(const float deltaTime)
+void Client::Input()
 {
 	// Grab input from the keyboard and deal with it accordingly
+	m_input = {};
+
+	// Spectators never drive
+	if (m_spectating)
+	{
+		return;
+	}
 
 	if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left))
 	{
-		m_players[m_userName].ChangeAngle(-3.14f * deltaTime);
+		m_input.steer -= 1;
 	}
 	if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right))
 	{
-		m_players[m_userName].ChangeAngle(3.14f * deltaTime);
+		m_input.steer += 1;
 	}
 
 	if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up))
 	{
-		m_players[m_userName].ChangeVelocity(0, -m_players[m_userName].GetSpeed() * deltaTime);
+		m_input.throttle = 1;
 	} else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down))
 	{
-		m_players[m_userName].ChangeVelocity(0, m_players[m_userName].GetSpeed() * deltaTime);
+		m_input.throttle = -1;
 	}
 }
 
-bool Client::AddPlayer(const std::string& username)
+bool Client::AddPlayer(const uint16_t networkId, const std::string& username)
 {
-	// Ensure that the username that is being added isn't the reserved one from the username
-	if (username != globals::k_reservedServerUsername)
+	// Ensure that the message is about a player rather than from the server
+	if (networkId != globals::k_serverNetworkId && username != globals::k_reservedServerUsername)
 	{
-		// If the key isn't already in the map, add it
-		if (!globals::is_key_in_map(m_players, username))
+		// Only add players that aren't already in the registry
+		if (m_players.Add(networkId, username))
 		{
-			std::cout << "Adding: " << username << " to the map..." << std::endl;
-			m_players.insert(std::make_pair(username, Player(m_carTexture)));
-
-			std::cout << "The new map size is: " << m_players.size() << std::endl;
+			LOG_DEBUG("Added {} with the network ID {}, there are now {} players", username, networkId, m_players.Size());
 			return true;
 		}
 	}
 	return false;
 }
 
-bool Client::RemovePlayer(const std::string& username)
+bool Client::RemovePlayer(const uint16_t networkId)
 {
-	// Only remove the username if it is valid
-	if (globals::is_key_in_map(m_players, username))
-	{
-		m_players.erase(username);
-		return true;
-	}
-
-	return false;
+	return m_players.Remove(networkId);
 }
 
-bool Client::ReceiveMessage()
+void Client::ReceiveMessages()
 {
-	sf::Packet inPacket;
-
-	// Receive some data from the server
-	if (m_socket.receive(inPacket) != sf::Socket::Done)
-		return false;
-
-	// Create a TcpDataPacket object to store the data received
-	TcpDataPacket inData;
-
-	inPacket >> inData;
+	// The network thread has already read and decoded everything, so this never waits on the socket
+	m_network.Receive([this](const NetworkMessage& message) { HandleMessage(message.packet, message.receivedAt); });
+}
 
+void Client::HandleMessage(const TcpDataPacket& inData, const int64_t receivedAt)
+{
 	// See if the data is from a new client...
-	if (AddPlayer(inData.m_userName))
+	if (AddPlayer(inData.m_networkId, inData.m_userName))
 	{
-		std::cout << "A new client connected with the username: " << inData.m_userName << std::endl;
+		LOG_INFO("A new client connected with the username {}", inData.m_userName);
 
-		m_players[inData.m_userName].SetColour({
+		Player& newPlayer = *m_players.Find(inData.m_networkId);
+
+		newPlayer.SetColour({
 				static_cast<sf::Uint8>(inData.m_red),
 				static_cast<sf::Uint8>(inData.m_green),
 				static_cast<sf::Uint8>(inData.m_blue)
 			});
 
-		m_players[inData.m_userName].SetPosition({
+		newPlayer.SetPosition({
 				inData.m_x,
 				inData.m_y
 			});
 
-		m_players[inData.m_userName].SetAngle(inData.m_angle);
+		newPlayer.SetAngle(inData.m_angle);
 	}
 
+	// The player the message is about, if it is about one
+	Player* player = m_players.Find(inData.m_networkId);
+
 	// Deal with the rest of the data received
 	switch (inData.m_type)
 	{
 	case eDataPacketType::e_MaxPlayers:
-		std::cout << "The server told me that there are the max amount of players in the game already..." << std::endl;
+		LOG_INFO("The server told me that there are the max amount of players in the game already");
+		break;
+
+		
+	case eDataPacketType::e_WorldSnapshot:
+		ApplyWorldSnapshot(inData.m_worldSnapshot);
+		break;
+
+		
+	case eDataPacketType::e_UserNameConfirmation:
+		LOG_INFO("The server found me a place in the next race");
+		JoinRace(inData);
+		break;
+
+		
+	case eDataPacketType::e_Heartbeat:
+	{
+		// Answer straight away so the server knows the connection is still alive, with how long
+		// the heartbeat was held here so the server can time the round trip
+		TcpDataPacket heartbeatData(eDataPacketType::e_Heartbeat, m_userName);
+		heartbeatData.m_networkId = m_networkId;
+		heartbeatData.m_originateTime = inData.m_transmitTime;
+		heartbeatData.m_receiveTime = receivedAt;
+		heartbeatData.m_transmitTime = network_clock::now();
+		SendMessage(heartbeatData);
+		break;
+	}
+
+	case eDataPacketType::e_ClockResponse:
+		m_clock.AddSample(inData.m_originateTime, inData.m_receiveTime, inData.m_transmitTime, receivedAt);
 		break;
 
 		
 	case eDataPacketType::e_UpdatePosition:
-		m_players[inData.m_userName].SetPosition({ inData.m_x, inData.m_y });
-		m_players[inData.m_userName].SetAngle(inData.m_angle);
+		if (player)
+		{
+			player->SetPosition({ inData.m_x, inData.m_y });
+			player->SetAngle(inData.m_angle);
+		}
+
+		if (inData.m_networkId != m_networkId)
+		{
+			m_viewTick = std::max(m_viewTick, inData.m_serverTick);
+		}
 		break;
 
 		
 	case eDataPacketType::e_StartGame:
-		std::cout << "The server told me that the game has started..." << std::endl;
+		LOG_INFO("The server told me that the game has started");
 		m_gameStarted = true;
 		break;
 
 		
 	case eDataPacketType::e_ClientDisconnected:
-		std::cout << "The server told me that the player: " << inData.m_userName << " disconnected..." << std::endl;
-		if (RemovePlayer(inData.m_userName))
+		LOG_INFO("The server told me that the player {} disconnected", inData.m_userName);
+		if (RemovePlayer(inData.m_networkId))
 		{
-			std::cout << "The disconnected player: " << inData.m_userName << " was removed successfully..." << std::endl;
+			LOG_DEBUG("The disconnected player {} was removed successfully", inData.m_userName);
 		} else
 		{
-			std::cout << "There was an error trying to remove " << inData.m_userName << "\n\t They may have been removed already...." << std::endl;
+			LOG_WARNING("There was an error trying to remove {}, they may have been removed already", inData.m_userName);
 		}
 		break;
 
 		
 	case eDataPacketType::e_CollisionData:
-		std::cout << "The server told me that player: " << inData.m_playerCollidedWith << " collided with me" << std::endl;
-
-		m_players[inData.m_userName].SetPosition({ inData.m_x, inData.m_y });
+		LOG_DEBUG("The server told me that {} collided with {}", inData.m_playerCollidedWith, inData.m_userName);
 
+		if (player)
+		{
+			player->SetPosition({ inData.m_x, inData.m_y });
+		}
 		break;
 
 		
 	case eDataPacketType::e_LapCompleted:
-		std::cout << "The server told me that I completed a lap!" << std::endl;
+		LOG_INFO("The server told me that I completed a lap");
 
 		m_lapsCompleted++;
 		break;
 
 		
 	case eDataPacketType::e_Overtaken:
-		std::cout << "The server updated me on my position in the race!" << std::endl;
+		LOG_DEBUG("The server updated me on my position in the race: {}", inData.m_positionInRace);
 
 		m_positionInRace = inData.m_positionInRace;
 		break;
 
 		
 	case eDataPacketType::e_RaceCompleted:
-		std::cout << "The server told me I have completed the race: " << std::endl;
+		LOG_INFO("The server told me I have completed the race");
 		m_completedRace = true;
 		break;
 
 		
 	case eDataPacketType::e_GameOver:
-		std::cout << "The server told me that the game has finished and the final positions are: " << std::endl;
+		LOG_INFO("The server told me that the game has finished and the final positions are:");
 
 		for (int i = 0; i < static_cast<int>(inData.m_placementOrder.m_racePositions.size()); ++i)
 		{
-			std::cout << i + 1 << ": " << inData.m_placementOrder.m_racePositions[i] << std::endl;
+			LOG_INFO("{}: {}", i + 1, inData.m_placementOrder.m_racePositions[i]);
 		}
 
 		m_finalPlayerOrder = inData.m_placementOrder.m_racePositions;
 
+		// The room closes after the race, so there is nothing to come back to if the connection drops
+		m_resumeToken = 0;
+
 		m_gameOver = true;
 		break;
 
@@ -385,66 +554,117 @@ bool Client::ReceiveMessage()
 	default:
 		break;
 	}
-
-	return true;
 }
 
 bool Client::SendMessage(const eDataPacketType type)
 {
+	const Player* player = m_players.Find(m_networkId);
+	if (!player)
+	{
+		return false;
+	}
+
 	// Push some data to the packet
-	const auto& playerPosition = m_players[m_userName].GetPosition();
-	sf::Packet outPacket;
+	const auto& playerPosition = player->GetPosition();
 
-	const TcpDataPacket outDataPacket(
+	TcpDataPacket outDataPacket(
 		type,
 		m_userName,
 		playerPosition.x,
 		playerPosition.y,
-		m_players[m_userName].GetAngle(),
-		m_players[m_userName].GetColour()
+		player->GetAngle(),
+		player->GetColour()
 	);
+	outDataPacket.m_networkId = m_networkId;
+	outDataPacket.m_serverTick = ViewTick();
 
-	outPacket << outDataPacket;
+	// The network thread sends it to the server via the socket
+	return m_network.Send(outDataPacket);
+}
 
-	// Send the packet to the server via the socket 
-	if (m_socket.send(outPacket) != sf::Socket::Done)
+uint32_t Client::ViewTick() const
+{
+	if (!m_clock.IsSynchronised())
 	{
-		return false;
+		return m_viewTick;
 	}
 
-	return true;
+	// The trip from the server takes about half of the round trip
+	const int64_t tripTime = network_clock::from_seconds(m_clock.Rtt().SmoothedRtt() / 2000.f);
+	const uint32_t screenTick = m_clock.LocalToTick(network_clock::now() - tripTime);
+
+	// A move that has been shown was certainly on screen
+	return std::max(screenTick, m_viewTick);
 }
 
 bool Client::SendMessage(TcpDataPacket& dp)
 {
-	sf::Packet outPacket;
-
-	outPacket << dp;
-
-	// Send the packet to the server via the socket
-	if (m_socket.send(outPacket) != sf::Socket::Done)
-	{
-		return false;
-	}
-
-	return true;
+	// The network thread sends it to the server via the socket
+	return m_network.Send(dp);
 }
 
-Client::Client(std::string username) :
+Client::Client(std::string username, const bool spectator) :
 	m_userName(std::move(username)),
+	m_networkId(globals::k_serverNetworkId),
+	m_spectating(spectator),
+	m_serverPort(0),
+	m_resumeToken(0),
+	m_disconnectedTime(0.f),
+	m_resumeTimer(0.f),
+	m_clock(car_physics::k_fixedStep),
+	m_clockSyncTimer(0.f),
+	m_viewTick(0),
 	m_packetDelay(0.05f),
 	m_packetTimer(0.f),
+	m_input{},
 	m_gameStarted(false),
 	m_completedRace(false),
 	m_gameOver(false),
 	m_lapsCompleted(0),
 	m_positionInRace(0)
 {
-	m_text.setString("Waiting for other players\nto connect...");
-	m_text.setCharacterSize(60);
+}
+
+void Client::ApplyWorldSnapshot(const WorldSnapshot& world)
+{
+	// Drop anybody who isn't in the race any more. Network IDs are reused, so a car with the same
+	// ID but a different name is somebody new and replaces the old player
+	for (int i = m_players.Size() - 1; i >= 0; --i)
+	{
+		const uint16_t networkId = m_players.NetworkIdAt(i);
+		const std::string& username = m_players.UsernameAt(i);
+		const bool inWorld = std::any_of(world.cars.begin(), world.cars.end(), [networkId, &username](const WorldCar& car)
+			{
+				return car.networkId == networkId && car.username == username;
+			});
+
+		if (!inWorld)
+		{
+			RemovePlayer(networkId);
+		}
+	}
+
+	for (const auto& car : world.cars)
+	{
+		AddPlayer(car.networkId, car.username);
+
+		Player* player = m_players.Find(car.networkId);
+		if (!player)
+		{
+			continue;
+		}
+
+		player->SetColour({ car.red, car.green, car.blue });
+		player->SetPosition({ car.x, car.y });
+		player->SetAngle(car.angle);
+	}
+
+	m_gameStarted = world.gameStarted;
+	m_gameOver = world.gameOver;
+	m_finalPlayerOrder = world.placementOrder;
 }
 
 void Client::SetGameFont(const sf::Font& font)
 {
-	m_text.setFont(font);
+	m_renderer.SetFont(font);
 }
@@ -1,10 +1,14 @@
 ﻿#pragma once
-#include <unordered_map>
 #include <SFML/Network.hpp>
 #include <SFML/Graphics.hpp>
 
+#include "ClientNetwork.h"
+#include "ClientRenderer.h"
 #include "Map.h"
 #include "Player.h"
+#include "PlayerRegistry.h"
+#include "RenderSnapshot.h"
+#include "TripleBuffer.h"
 #include "../Shared Files/Data.h"
 
 
@@ -19,30 +23,44 @@ public:
 	 * \brief Returns a heap allocated Client object if initialisation was successful
 	 * \param username The chosen username of the client
 	 * \param port The port to connect to the server on via TCP
+	 * \param spectator True to watch the race without driving, from the
+	 * server or a relay
 	 * \return A unique_ptr if initialisation was successful, nullptr if not
 	 */
-	static std::unique_ptr<Client> CreateClient(const std::string& username, unsigned short port);
+	static std::unique_ptr<Client> CreateClient(const std::string& username, unsigned short port, bool spectator = false);
 
 	/**
-	 * \brief Handles input for the game
-	 * \param deltaTime The time difference between
-	 * frames, for frame-rate independence
+	 * \brief Reads the controls for the game, they are applied
+	 * by the physics steps in the next Update
 	 */
-	void Input(float deltaTime);
+	void Input();
 	
 	/**
 	 * \brief Updates the objects in the game and
-	 * communicates with the server
+	 * communicates with the server. The player's car is moved
+	 * in fixed physics steps so it matches the server, and
+	 * the result is published for the render thread to draw
 	 * \param deltaTime The time difference between
 	 * frames, for frame-rate independence
+	 * \param physicsSteps The amount of fixed physics steps
+	 * due this frame, worked out by the FramePacer
 	 */
-	void Update(float deltaTime);
+	void Update(float deltaTime, int physicsSteps);
 	
 	/**
-	 * \brief Renders the game to the screen
-	 * \param window The RenderWindow to render to
+	 * \brief Starts drawing the game to the window on the render thread
+	 * \param window The RenderWindow to render to, it must not be
+	 * active on the calling thread
+	 * \param mode How the render thread waits between frames
+	 * \param frameRate The frames per second to aim for when
+	 * the render thread paces itself
+	 */
+	void StartRendering(sf::RenderWindow& window, ePacingMode mode, float frameRate);
+
+	/**
+	 * \brief Stops the render thread, call before closing the window
 	 */
-	void Render(sf::RenderWindow& window);
+	void StopRendering();
 	
 	/**
 	 * \brief Sets the font to be used in the game
@@ -54,16 +72,49 @@ private:
 	// The socket handles TCP communication between the client and the server
 	sf::TcpSocket m_socket;
 
+	// Reads and writes the socket on its own thread once the client has connected
+	ClientNetwork m_network;
+
 	// The username is a unique identifier for the client. The client will not
 	// initialise if the username is taken
 	std::string m_userName;
 
+	// The network ID the server gave this client, the handle of the local player. Spectators
+	// don't have a player, so they keep the server's ID and never send anything
+	uint16_t m_networkId;
+
+	// Flag for whether the client only watches the race
+	bool m_spectating;
+
+	// The port the server is on, kept for reconnecting
+	unsigned short m_serverPort;
+
+	// The secret that resumes the session if the connection drops, 0 if there is no session to resume
+	uint64_t m_resumeToken;
+
+	// How long the connection has been down, and the countdown to the next attempt to resume
+	float m_disconnectedTime;
+	float m_resumeTimer;
+
+	// How far the server's clock is from ours, so the server tick on screen can be worked out from
+	// the local time
+	ClockSync m_clock;
+
+	// The countdown to the next time the server is asked the time
+	float m_clockSyncTimer;
+
+	// The server tick of the newest move of another car that has been shown
+	uint32_t m_viewTick;
+
 	// The time delay between packets sent
 	float m_packetDelay;
 
 	// The countdown between packets sent
 	float m_packetTimer;
 
+	// The controls read by Input, applied on every physics step of the next Update
+	car_physics::CarInput m_input;
+
 	// Flag for whether the game has started and the track and cars should be drawn
 	// and updated
 	bool m_gameStarted;
@@ -81,12 +132,10 @@ private:
 	// The player's position in the race
 	int m_positionInRace;
 
-	// The container that holds all of the connected players in the game. As the username of
-	// each client is their unique identifier, it was chosen to be the key of the unordered map
-	std::unordered_map<std::string, Player> m_players;
+	// All of the connected players in the game, found by the network ID the server gave them
+	PlayerRegistry m_players;
 
-	// This vector is accessed at the end of the race. It stores the order that the connected
-	// clients placed at the end of the race and is used when drawing the end screen
+	// The final order of the racers, once the game is over
 	std::vector<std::string> m_finalPlayerOrder;
 
 	// The texture used for drawing the player
@@ -95,8 +144,11 @@ private:
 	// The track of the game
 	Map m_background;
 
-	// Text used to draw the UI in the game
-	sf::Text m_text;
+	// What to draw, published after every update for the render thread
+	TripleBuffer<RenderSnapshot> m_snapshots;
+
+	// Draws the game on its own thread, declared last so it stops before anything it draws is destroyed
+	ClientRenderer m_renderer;
 
 	/**
 	 * \brief Initialises a client object if it is able to load the appropriate files
@@ -107,29 +159,92 @@ private:
 	bool Initialise(unsigned short port);
 
 	/**
-	 * \brief Adds a player to the m_players map
+	 * \brief Takes the place on the grid the server gave this client
+	 * \param confirmation The e_UserNameConfirmation with the network ID, resume token, colour and
+	 * starting position
+	 */
+	void JoinRace(const TcpDataPacket& confirmation);
+
+	/**
+	 * \brief Connects the socket to the server, introduces the client and waits for the reply
+	 * \param greeting The first message to send
+	 * \param timeout The longest to wait for the connection and for the reply, in seconds
+	 * \param reply The server's reply
+	 * \return True if the server replied in time, the socket is left non-blocking
+	 */
+	bool Connect(const TcpDataPacket& greeting, float timeout, TcpDataPacket& reply);
+
+	/**
+	 * \brief Tries to resume the session now and then while the connection is down, until the
+	 * server will have given up on it
+	 * \param deltaTime The time since the last update
+	 */
+	void CheckConnection(float deltaTime);
+
+	/**
+	 * \brief Asks the server the time now and then to keep m_clock in step, players only
+	 * \param deltaTime The time since the last update
+	 */
+	void SyncClock(float deltaTime);
+
+	/**
+	 * \brief Reconnects to the server with the resume token and catches up with the race
+	 * \return True if the session was resumed and the network thread is running again
+	 */
+	bool ResumeSession();
+
+	/**
+	 * \brief Adds a player to the m_players registry
+	 * \param networkId The network ID of the player to add
 	 * \param username The username of the player to add
 	 * \return True if the player was added successfully
 	 */
-	bool AddPlayer(const std::string& username);
+	bool AddPlayer(uint16_t networkId, const std::string& username);
 	
 	/**
-	 * \brief Removes a player from the m_players map
-	 * \param username The username of the player to remove
+	 * \brief Removes a player from the m_players registry
+	 * \param networkId The network ID of the player to remove
 	 * \return True if the player was removed successfully
 	 */
-	bool RemovePlayer(const std::string& username);
+	bool RemovePlayer(uint16_t networkId);
 	
 	/**
-	 * \brief Receives a message from the server
-	 * \return True if the message was received successfully
+	 * \brief Deals with every message the network thread has received since the last frame
+	 */
+	void ReceiveMessages();
+
+	/**
+	 * \brief Copies what the render thread needs to draw into a snapshot and publishes it
+	 */
+	void PublishSnapshot();
+
+	/**
+	 * \brief Brings the players and the state of the race in line with a keyframe, for spectators
+	 * \param world The keyframe from the server or relay
 	 */
-	bool ReceiveMessage();
+	void ApplyWorldSnapshot(const WorldSnapshot& world);
+
+	/**
+	 * \brief Applies a message from the server to the game
+	 * \param inData The message received
+	 * \param receivedAt When the message arrived, from network_clock::now
+	 */
+	void HandleMessage(const TcpDataPacket& inData, int64_t receivedAt);
+
+	/**
+	 * \brief Works out which server tick is on screen, sent with every update so the server can judge
+	 * it against the race as it looked here. Every change is shown as soon as it arrives, so once the
+	 * clock is in step that is the server's time now less the trip here, which stays right while
+	 * the other cars sit still and send nothing. Until then it is the newest move that has been shown
+	 * \return The server tick on screen, 0 if it isn't known yet
+	 */
+	[[nodiscard]] uint32_t ViewTick() const;
+
 	/**
 	 * \brief Sends a generic TcpDataPacket to the server to communicate
 	 * game-play to the server
 	 * \param type The type of TcpDataPacket to send
-	 * \return True if the message was sent successfully
+	 * \return True if the message was queued for the network thread
 	 */
 	bool SendMessage(eDataPacketType type);
 	
@@ -137,13 +252,14 @@ private:
 	 * \brief Sends a TcpDataPacket object to the server to communicate
 	 * game-play
 	 * \param dp The TcpDataPacket to send
-	 * \return True if the message was sent successfully
+	 * \return True if the message was queued for the network thread
 	 */
 	bool SendMessage(TcpDataPacket& dp);
 
 	/**
 	 * \brief Constructs a Client object
 	 * \param username The chosen username of the client
+	 * \param spectator True to watch the race without driving
 	 */
-	explicit Client(std::string username);
+	Client(std::string username, bool spectator);
 };
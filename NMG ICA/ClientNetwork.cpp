@@ -0,0 +1,171 @@
+#include "ClientNetwork.h"
+
+#include <chrono>
+
+#include "../Shared Files/Logger.h"
+
+namespace
+{
+	// The longest the network thread waits for the server before it checks for messages to send
+	constexpr int POLL_INTERVAL_MILLISECONDS = 1;
+} // anonymous namespace
+
+ClientNetwork::ClientNetwork() :
+	m_socket(nullptr),
+	m_running(false),
+	m_connected(false)
+{
+}
+
+ClientNetwork::~ClientNetwork()
+{
+	Stop();
+}
+
+void ClientNetwork::Start(sf::TcpSocket& socket)
+{
+	if (m_running)
+	{
+		return;
+	}
+
+	m_socket = &socket;
+	m_running = true;
+	m_connected = true;
+	m_thread = std::thread(&ClientNetwork::Run, this);
+}
+
+void ClientNetwork::Stop()
+{
+	m_running = false;
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+
+	// Nothing queued for the old connection belongs on the next one, a resumed session starts again
+	// from a keyframe. The network thread has stopped, so this thread can empty both ends
+	while (m_outgoing.TryPop([](const TcpDataPacket&) {}))
+	{
+	}
+
+	while (m_incoming.TryPop([](const NetworkMessage&) {}))
+	{
+	}
+}
+
+bool ClientNetwork::Send(const TcpDataPacket& packet)
+{
+	// Copy into the cell rather than constructing a new packet, so its strings keep their memory
+	if (!m_outgoing.TryPush([&packet](TcpDataPacket& cell) { cell = packet; }))
+	{
+		LOG_WARNING("The outgoing message queue is full, a message was dropped");
+		return false;
+	}
+	return true;
+}
+
+void ClientNetwork::Run()
+{
+	sf::SocketSelector selector;
+	selector.add(*m_socket);
+
+	sf::Packet inPacket;
+	sf::Packet outPacket;
+	bool sending = false;
+
+	while (m_running)
+	{
+		if (!SendQueued(outPacket, sending))
+		{
+			break;
+		}
+
+		// Sleep until the server sends something, waking up now and then to send the game's messages
+		if (selector.wait(sf::milliseconds(POLL_INTERVAL_MILLISECONDS)) && !ReceiveAvailable(inPacket))
+		{
+			break;
+		}
+	}
+
+	m_connected = false;
+}
+
+bool ClientNetwork::SendQueued(sf::Packet& outPacket, bool& sending)
+{
+	while (true)
+	{
+		if (!sending)
+		{
+			if (!m_outgoing.TryPop([&outPacket](const TcpDataPacket& packet)
+				{
+					outPacket.clear();
+					outPacket << packet;
+				}))
+			{
+				return true;
+			}
+
+			sending = true;
+		}
+
+		// The packet remembers how much of it was sent, so a partial send carries on where it left off
+		switch (m_socket->send(outPacket))
+		{
+		case sf::Socket::Done:
+			sending = false;
+			break;
+
+		case sf::Socket::NotReady:
+		case sf::Socket::Partial:
+			return true;
+
+		case sf::Socket::Disconnected:
+			LOG_WARNING("The server disconnected while a message was being sent");
+			return false;
+
+		default:
+			LOG_ERROR("A message couldn't be sent to the server");
+			sending = false;
+			break;
+		}
+	}
+}
+
+bool ClientNetwork::ReceiveAvailable(sf::Packet& inPacket)
+{
+	while (true)
+	{
+		switch (m_socket->receive(inPacket))
+		{
+		case sf::Socket::Done:
+		{
+			const int64_t receivedAt = network_clock::now();
+
+			// Wait for the game thread to make room rather than lose a message, the messages behind
+			// this one stay in the socket until then
+			while (!m_incoming.TryPush([&](NetworkMessage& message)
+				{
+					inPacket >> message.packet;
+					message.receivedAt = receivedAt;
+				}))
+			{
+				if (!m_running)
+				{
+					return false;
+				}
+				std::this_thread::yield();
+			}
+			break;
+		}
+
+		case sf::Socket::Disconnected:
+			LOG_WARNING("The server disconnected");
+			return false;
+
+		default:
+			// Nothing more has fully arrived yet
+			return true;
+		}
+	}
+}
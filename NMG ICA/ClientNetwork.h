@@ -0,0 +1,122 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <SFML/Network.hpp>
+
+#include "../Shared Files/Data.h"
+#include "../Shared Files/NetworkClock.h"
+#include "../Shared Files/RingBuffer.h"
+
+/**
+ * \brief A message from the server, decoded on the network thread
+ */
+struct NetworkMessage
+{
+	TcpDataPacket packet;
+
+	// When the message finished arriving, from network_clock::now
+	int64_t receivedAt = 0;
+};
+
+/**
+ * \brief Runs the client's socket on its own thread, so messages are read and timestamped as soon as they
+ * arrive however long the frames take. Decoded messages are handed to the game thread through one
+ * lock-free queue and the game thread's messages go back to the socket through another
+ */
+class ClientNetwork
+{
+public:
+	ClientNetwork();
+
+	~ClientNetwork();
+
+	// Non-copyable and non-moveable
+	ClientNetwork(const ClientNetwork& other) = delete;
+	ClientNetwork& operator=(const ClientNetwork& other) = delete;
+
+	ClientNetwork(ClientNetwork&& other) = delete;
+	ClientNetwork& operator=(ClientNetwork&& other) = delete;
+
+	/**
+	 * \brief Starts the network thread, from then on only the network thread may use the socket
+	 * \param socket A non-blocking socket connected to the server, it must outlive the network thread
+	 */
+	void Start(sf::TcpSocket& socket);
+
+	/**
+	 * \brief Stops the network thread, anything still queued is thrown away
+	 */
+	void Stop();
+
+	/**
+	 * \return False once the server has disconnected, the thread has stopped by then and the socket
+	 * can be used again after a call to Stop
+	 */
+	[[nodiscard]] bool IsConnected() const { return m_connected; }
+
+	/**
+	 * \brief Queues a message for the network thread to send
+	 * \param packet The message to send
+	 * \return False if the queue was full and the message was dropped
+	 */
+	bool Send(const TcpDataPacket& packet);
+
+	/**
+	 * \brief Hands every message that has arrived since the last call to the handler, oldest first.
+	 * Must only be called from the game thread
+	 * \tparam Handler A callable taking a const NetworkMessage&
+	 * \param handler Deals with each message, the message is only valid during the call
+	 * \return The amount of messages handled
+	 */
+	template<typename Handler>
+	int Receive(Handler&& handler)
+	{
+		int received = 0;
+		while (m_incoming.TryPop([&](const NetworkMessage& message) { handler(message); }))
+		{
+			++received;
+		}
+		return received;
+	}
+
+private:
+	static constexpr size_t k_incomingCapacity = 256;
+	static constexpr size_t k_outgoingCapacity = 64;
+
+	// Messages from the server, filled by the network thread and emptied by the game thread
+	SpscRingBuffer<NetworkMessage, k_incomingCapacity> m_incoming;
+
+	// Messages for the server, filled by the game thread and emptied by the network thread
+	SpscRingBuffer<TcpDataPacket, k_outgoingCapacity> m_outgoing;
+
+	sf::TcpSocket* m_socket;
+
+	// Flag for whether the network thread should keep running
+	std::atomic<bool> m_running;
+
+	// Flag for whether the network thread is still talking to the server
+	std::atomic<bool> m_connected;
+
+	std::thread m_thread;
+
+	/**
+	 * \brief The body of the network thread, moves messages between the socket and the queues
+	 */
+	void Run();
+
+	/**
+	 * \brief Sends queued messages until the queue is empty or the socket can't take any more
+	 * \param outPacket The packet being sent, a packet the socket only took part of is finished first
+	 * \param sending Flag for whether outPacket still has data to send
+	 * \return False if the server disconnected
+	 */
+	bool SendQueued(sf::Packet& outPacket, bool& sending);
+
+	/**
+	 * \brief Reads and queues every message the socket has for us
+	 * \param inPacket Scratch space for the message being received
+	 * \return False if the server disconnected
+	 */
+	bool ReceiveAvailable(sf::Packet& inPacket);
+};
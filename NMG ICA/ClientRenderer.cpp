@@ -0,0 +1,125 @@
+#include "ClientRenderer.h"
+
+#include "../Shared Files/CarPhysics.h"
+
+ClientRenderer::ClientRenderer() :
+	m_window(nullptr),
+	m_map(nullptr),
+	m_snapshots(nullptr),
+	m_pacingMode(ePacingMode::e_TargetRate),
+	m_frameRate(60.f),
+	m_resultsLaidOut(false),
+	m_running(false)
+{
+}
+
+ClientRenderer::~ClientRenderer()
+{
+	Stop();
+}
+
+void ClientRenderer::SetCarTexture(const sf::Texture& texture)
+{
+	m_carBatch.SetCarTexture(texture);
+}
+
+void ClientRenderer::SetFont(const sf::Font& font)
+{
+	m_hud.SetFont(font);
+	m_carBatch.SetFont(font);
+}
+
+void ClientRenderer::Start(sf::RenderWindow& window, const Map& map, TripleBuffer<RenderSnapshot>& snapshots,
+	const std::string& localUsername, const ePacingMode mode, const float frameRate)
+{
+	if (m_running)
+	{
+		return;
+	}
+
+	m_window = &window;
+	m_map = &map;
+	m_snapshots = &snapshots;
+	m_localUsername = localUsername;
+	m_pacingMode = mode;
+	m_frameRate = frameRate;
+
+	m_running = true;
+	m_thread = std::thread(&ClientRenderer::Run, this);
+}
+
+void ClientRenderer::Stop()
+{
+	m_running = false;
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+}
+
+void ClientRenderer::Run()
+{
+	// The window's OpenGL context can only be active on one thread at a time
+	m_window->setActive(true);
+	m_window->setVerticalSyncEnabled(m_pacingMode == ePacingMode::e_DisplaySync);
+
+	// The render thread has no physics to step, it only uses the pacer to wait between frames
+	FramePacer pacer("Render", m_pacingMode, m_frameRate, car_physics::k_fixedStep, car_physics::k_maxCatchUp);
+
+	while (m_running)
+	{
+		pacer.BeginFrame();
+
+		// If the game thread hasn't published since the last frame, the last snapshot is drawn again
+		m_snapshots->Consume();
+
+		m_window->clear();
+		Draw(m_snapshots->ReadBuffer());
+		m_window->display();
+
+		pacer.WaitForNextFrame();
+	}
+
+	m_window->setActive(false);
+}
+
+void ClientRenderer::Draw(const RenderSnapshot& snapshot)
+{
+	// A spectator can stay for the next room, whose results are laid out afresh
+	if (snapshot.phase != eGamePhase::e_Results)
+	{
+		m_resultsLaidOut = false;
+	}
+
+	switch (snapshot.phase)
+	{
+	case eGamePhase::e_Waiting:
+		m_hud.RenderWaiting(*m_window);
+		break;
+
+	case eGamePhase::e_Racing:
+		m_map->Render(*m_window);
+
+		// Every car with its username above it, in one draw call
+		m_carBatch.Update(snapshot);
+		m_carBatch.Render(*m_window);
+
+		// Draw the UI last, it only changes when the laps, position or players do
+		if (!snapshot.spectating)
+		{
+			m_hud.SetRaceStatus(snapshot.lapsCompleted, snapshot.positionInRace, static_cast<int>(snapshot.cars.size()));
+			m_hud.RenderRace(*m_window);
+		}
+		break;
+
+	case eGamePhase::e_Results:
+		// Display the final order of the racers
+		if (!m_resultsLaidOut)
+		{
+			m_hud.SetResults(snapshot.placementOrder, m_localUsername);
+			m_resultsLaidOut = true;
+		}
+		m_hud.RenderResults(*m_window);
+		break;
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <thread>
+#include <SFML/Graphics.hpp>
+
+#include "CarBatch.h"
+#include "FramePacer.h"
+#include "Hud.h"
+#include "Map.h"
+#include "RenderSnapshot.h"
+#include "TripleBuffer.h"
+
+/**
+ * \brief Draws the game on its own thread, so a slow present or a driver stall never holds up the
+ * simulation or the network. Each frame it takes the newest RenderSnapshot the game thread has
+ * published, draws it and presents it, pacing itself with its own FramePacer
+ */
+class ClientRenderer
+{
+public:
+	ClientRenderer();
+
+	~ClientRenderer();
+
+	// Non-copyable and non-moveable
+	ClientRenderer(const ClientRenderer& other) = delete;
+	ClientRenderer& operator=(const ClientRenderer& other) = delete;
+
+	ClientRenderer(ClientRenderer&& other) = delete;
+	ClientRenderer& operator=(ClientRenderer&& other) = delete;
+
+	/**
+	 * \param texture The texture of a car, it must outlive the renderer
+	 */
+	void SetCarTexture(const sf::Texture& texture);
+
+	/**
+	 * \param font The font to write with, it must outlive the renderer
+	 */
+	void SetFont(const sf::Font& font);
+
+	/**
+	 * \brief Starts the render thread. The window must not be active on any other thread, and nothing
+	 * but the render thread may draw to it until Stop is called
+	 * \param window The window to draw to
+	 * \param map The track to draw, it must outlive the render thread
+	 * \param snapshots Where the game thread publishes what to draw
+	 * \param localUsername The username of this client, which is highlighted in the results
+	 * \param mode How the render thread waits between frames
+	 * \param frameRate The frames per second to aim for with ePacingMode::e_TargetRate
+	 */
+	void Start(sf::RenderWindow& window, const Map& map, TripleBuffer<RenderSnapshot>& snapshots,
+		const std::string& localUsername, ePacingMode mode, float frameRate);
+
+	/**
+	 * \brief Stops the render thread and gives the window back to the calling thread
+	 */
+	void Stop();
+
+private:
+	sf::RenderWindow* m_window;
+	const Map* m_map;
+	TripleBuffer<RenderSnapshot>* m_snapshots;
+
+	std::string m_localUsername;
+
+	ePacingMode m_pacingMode;
+	float m_frameRate;
+
+	// Draws all of the cars and their names together
+	CarBatch m_carBatch;
+
+	// The text drawn over the game
+	Hud m_hud;
+
+	// Flag for whether the final placements have been laid out, they don't change until the results
+	// are taken down
+	bool m_resultsLaidOut;
+
+	// Flag for whether the render thread should keep running
+	std::atomic<bool> m_running;
+
+	std::thread m_thread;
+
+	/**
+	 * \brief The body of the render thread, draws and presents frames until the renderer is stopped
+	 */
+	void Run();
+
+	/**
+	 * \brief Draws one frame to the window
+	 * \param snapshot What to draw
+	 */
+	void Draw(const RenderSnapshot& snapshot);
+};
@@ -1,21 +1,20 @@
 ﻿#include "ClientSnapshot.h"
 
-#include <iostream>
+#include "Globals.h"
 
-ClientSnapshot::ClientSnapshot(const sf::Vector2f& position, const float angle) :
+ClientSnapshot::ClientSnapshot() :
+	role(eSessionRole::e_Pending),
+	networkId(globals::k_serverNetworkId),
 	socket(new sf::TcpSocket()),
-	position(position),
-	angle(angle),
-	checkPointsPassed(),
-	nextAICheckpoint(0),
-	lapsCompleted(0),
-	raceCompleted(false)
+	car(-1),
+	gridSlot(-1),
+	colour(sf::Color::White),
+	resumeToken(0),
+	timers{},
+	messagesThisWindow(0),
+	rtt(),
+	joinedAt(0)
 {
-	// Start having completed no checkpoints
-	for (int i = 0; i < globals::game::k_numCheckPoints; ++i)
-	{
-		checkPointsPassed[i] = false;
-	}
 }
 
 ClientSnapshot::~ClientSnapshot()
@@ -23,44 +22,18 @@ ClientSnapshot::~ClientSnapshot()
 	delete socket;
 }
 
-bool ClientSnapshot::AllCheckPointsPassed()
+void ClientSnapshot::Reset()
 {
-	int passedCheckPoints = 0;
-	for (const auto& cp : checkPointsPassed)
-	{
-		if (cp)
-		{
-			passedCheckPoints++;
-		}
-	}
-	return passedCheckPoints == globals::game::k_numCheckPoints;
+	role = eSessionRole::e_Pending;
+	username.clear();
+	networkId = globals::k_serverNetworkId;
+	car = -1;
+	gridSlot = -1;
+	colour = sf::Color::White;
+	unsent.clear();
+	resumeToken = 0;
+	timers.fill({});
+	messagesThisWindow = 0;
+	rtt = RttEstimator();
+	joinedAt = 0;
 }
-
-void ClientSnapshot::ResetCheckPoints()
-{
-	std::cout << "Completed a lap, resetting the checkpoints" << std::endl;
-	for (auto& point : checkPointsPassed)
-	{
-		point = false;
-	}
-}
-
-int ClientSnapshot::HighestCheckPointPassed()
-{
-	for (int i = globals::game::k_numCheckPoints - 1; i >= 0; --i)
-	{
-		if (checkPointsPassed[i])
-		{
-			return i;
-		}
-	}
-	return -1;
-}
-
-void ClientSnapshot::PrintCheckPoints()
-{
-	for (int i = 0; i < static_cast<int>(checkPointsPassed.size()); ++i)
-	{
-		std::cout << "Checkpoint: " << i << (checkPointsPassed[i] ? " passed" : " not passed") << std::endl;
-	}
-}
\ No newline at end of file
@@ -1,66 +1,112 @@
 ﻿#pragma once
 #include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <SFML/Graphics/Color.hpp>
 #include <SFML/Network/TcpSocket.hpp>
-#include <SFML/System/Vector2.hpp>
 
-#include "Globals.h"
+#include "TimerWheel.h"
+#include "../Shared Files/NetworkClock.h"
+
+/**
+ * \brief What a session is for
+ */
+enum class eSessionRole : uint8_t
+{
+	// Accepted, but the client hasn't been let in yet
+	e_Pending,
+	e_Player,
+	e_Spectator,
+	// A player whose connection dropped during the race, waiting for them to resume it
+	e_Parked,
+	// A player waiting in the matchmaking queue for the next room
+	e_Queued,
+	// A car driven by the server's AI to fill the grid, it has no connection
+	e_Bot
+};
+
+/**
+ * \brief The timers the server keeps for each session
+ */
+enum class eSessionTimer : uint8_t
+{
+	// A new connection has to introduce itself before this fires
+	e_Handshake,
+	// Time to send the client a heartbeat
+	e_HeartbeatSend,
+	// The client has been quiet for too long
+	e_HeartbeatTimeout,
+	// A parked session has waited long enough for its client
+	e_ResumeExpiry,
+	// The end of the window the client's messages are counted in
+	e_RateLimitWindow,
+	e_Count
+};
 
 /**
  * \brief The ClientSnapshot is a simplified version of the Client, it is used by the server to keep
- * track of the game state
+ * track of the session with each client. The car that the client drives is stored in the
+ * server's CarStateStore and referred to by index. Spectators have a session too, but no car.
+ * The snapshots live in the slots of the server's SessionTable and are reused, socket and all
  */
 struct ClientSnapshot
 {
-	ClientSnapshot(const sf::Vector2f& position, const float angle);
+	ClientSnapshot();
 
 	~ClientSnapshot();
 
-	/**
-	 * \brief Checks if all of the checkpoints have been passed by the client
-	 * i.e. whether they have completed a lap
-	 * \return True if they have passed all of the checkpoints in the game
-	 */
-	bool AllCheckPointsPassed();
+	// Non-copyable and non-moveable, it owns its socket
+	ClientSnapshot(const ClientSnapshot& other) = delete;
+	ClientSnapshot& operator=(const ClientSnapshot& other) = delete;
 
-	/**
-	 * \brief Resets each checkpoint back to false if the client has lapped
-	 */
-	void ResetCheckPoints();
+	ClientSnapshot(ClientSnapshot&& other) = delete;
+	ClientSnapshot& operator=(ClientSnapshot&& other) = delete;
 
 	/**
-	 * \brief Finds the index of the highest checkpoint passed by the client
-	 * \return The index of the highest checkpoint passed by the client, -1 if
-	 * no checkpoints have been passed
+	 * \brief Puts everything back the way a new snapshot has it, keeping the socket to reuse
 	 */
-	int HighestCheckPointPassed();
+	void Reset();
 
-	/**
-	 * \brief Prints the checkpoints visited by the client - useful for debugging!
-	 */
-	void PrintCheckPoints();
+	// What the session is for
+	eSessionRole role;
 
 	// The unique identifier of the client
 	std::string username;
 
-	// Pointer to the socket used for communication to the client
+	// The small ID sent with every message about the client, so that clients can find its player
+	// without looking up the username. The lowest free ID is handed out, so IDs stay small
+	uint16_t networkId;
+
+	// Pointer to the socket used for communication to the client, it never blocks
 	sf::TcpSocket* socket;
 
-	// The current position of the client
-	sf::Vector2f position;
+	// Whole framed packets the socket couldn't take yet, sent before anything newer
+	std::vector<char> unsent;
+
+	// The index of the client's car in the CarStateStore, -1 until the client is accepted
+	// and always -1 for spectators
+	int car;
+
+	// The place on the starting grid the client's car took, which also picks its colour. -1 until
+	// the client is given a car
+	int gridSlot;
+
+	// The colour of the client's car, so spectators can be told it in a keyframe
+	sf::Color colour;
 
-	// The current angle of the client
-	float angle;
+	// The secret the client gives to resume the session if its connection drops, 0 for spectators
+	uint64_t resumeToken;
 
-	// Each of the checkpoints in the game and whether they have been passed by the
-	// client or not
-	std::array<bool, globals::game::k_numCheckPoints> checkPointsPassed;
+	// The session's timers in the server's TimerWheel, indexed by eSessionTimer
+	std::array<TimerHandle, static_cast<size_t>(eSessionTimer::e_Count)> timers;
 
-	// The next checkpoint for the AI client to travel to 
-	int nextAICheckpoint;
+	// The amount of messages received in the current rate limit window
+	int messagesThisWindow;
 
-	// The amount of laps completed by the client
-	int lapsCompleted;
+	// The round trip time to the client, measured with the heartbeats
+	RttEstimator rtt;
 
-	// Whether the client has finished the race
-	bool raceCompleted;
+	// When the client asked to race, in microseconds of server time, so its time to race is known
+	int64_t joinedAt;
 };
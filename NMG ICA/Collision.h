@@ -0,0 +1,45 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+
+namespace collision
+{
+	/**
+	 * \brief A rectangle that can be rotated to any angle, described by its centre, the two
+	 * unit axes of the rectangle and its half width and half height along those axes
+	 */
+	struct OrientedBox
+	{
+		sf::Vector2f centre;
+		sf::Vector2f axisX;
+		sf::Vector2f axisY;
+		sf::Vector2f halfExtents;
+	};
+
+	/**
+	 * \brief Builds the collision box of a car
+	 * \param position The position of the car, which is the centre of the sprite
+	 * \param angle The rotation of the car in radians
+	 * \return The box covering the car's sprite
+	 */
+	OrientedBox make_car_box(const sf::Vector2f& position, float angle);
+
+	/**
+	 * \brief Tests two oriented boxes against each other using the Separating Axis Theorem. Only the
+	 * four edge normals need testing for a pair of rectangles so the cost is constant
+	 * \param a The first box
+	 * \param b The second box
+	 * \param minimumTranslation Set to the smallest vector that moves a out of b if they overlap
+	 * \return True if the boxes overlap
+	 */
+	bool separating_axis_test(const OrientedBox& a, const OrientedBox& b, sf::Vector2f& minimumTranslation);
+
+	/**
+	 * \brief Tests whether two line segments cross or touch
+	 * \param aStart The start of the first segment
+	 * \param aEnd The end of the first segment
+	 * \param bStart The start of the second segment
+	 * \param bEnd The end of the second segment
+	 * \return True if the segments share a point
+	 */
+	bool segments_intersect(const sf::Vector2f& aStart, const sf::Vector2f& aEnd, const sf::Vector2f& bStart, const sf::Vector2f& bEnd);
+} // namespace collision
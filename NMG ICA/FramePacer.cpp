@@ -0,0 +1,190 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "../Shared Files/Logger.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+namespace
+{
+	// How many recent frames the statistics cover, and how often they are logged
+	constexpr size_t STATISTICS_FRAMES = 512;
+	constexpr std::chrono::seconds REPORT_INTERVAL(10);
+
+	// A frame that takes this many times longer than expected counts as jank
+	constexpr float JANK_FACTOR = 1.5f;
+
+	// The sleep statistics stop growing their sample count here, so they keep adapting if the
+	// machine's timer changes
+	constexpr int64_t MAX_SLEEP_SAMPLES = 1000;
+
+	// How long each sleep asks for. The safety margin on top of the mean sleep is never more than
+	// this, so a few badly overslept frames can't stop the pacer sleeping at all
+	constexpr std::chrono::milliseconds SLEEP_QUANTUM(1);
+
+	/**
+	 * \param duration A length of time
+	 * \return The length in seconds
+	 */
+	double to_seconds(const std::chrono::steady_clock::duration duration)
+	{
+		return std::chrono::duration<double>(duration).count();
+	}
+} // anonymous namespace
+
+FramePacer::FramePacer(const char* name, const ePacingMode mode, const float targetFrameRate, const float fixedStep, const float maxCatchUp) :
+	m_name(name),
+	m_mode(mode),
+	m_framePeriod(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / std::max(1.f, targetFrameRate)))),
+	m_frameStart(Clock::now()),
+	m_nextFrame(m_frameStart + m_framePeriod),
+	m_frameTime(0.f),
+	m_fixedStep(fixedStep),
+	m_maxCatchUp(maxCatchUp),
+	m_physicsAccumulator(0.f),
+	m_physicsSteps(0),
+	m_sleepMean(0.002),
+	m_sleepSquaredDifferences(0.0),
+	m_sleepSamples(1),
+	m_frameTimes(STATISTICS_FRAMES, 0.f),
+	m_nextFrameTime(0),
+	m_recordedFrames(0),
+	m_lastReport(m_frameStart)
+{
+	m_sortedFrameTimes.reserve(STATISTICS_FRAMES);
+
+#ifdef _WIN32
+	// Windows only wakes sleeping threads every 15.6ms unless asked to do better
+	timeBeginPeriod(1);
+#endif
+}
+
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+void FramePacer::BeginFrame()
+{
+	const Clock::time_point now = Clock::now();
+	m_frameTime = static_cast<float>(to_seconds(now - m_frameStart));
+	m_frameStart = now;
+
+	// Work out how many whole physics steps the frame covers, the rest carries over to the next frame
+	m_physicsAccumulator = std::min(m_physicsAccumulator + m_frameTime, m_maxCatchUp);
+	m_physicsSteps = static_cast<int>(m_physicsAccumulator / m_fixedStep);
+	m_physicsAccumulator -= static_cast<float>(m_physicsSteps) * m_fixedStep;
+
+	m_frameTimes[m_nextFrameTime] = m_frameTime * 1000.f;
+	m_nextFrameTime = (m_nextFrameTime + 1) % m_frameTimes.size();
+	m_recordedFrames = std::min(m_recordedFrames + 1, m_frameTimes.size());
+
+	if (now - m_lastReport >= REPORT_INTERVAL)
+	{
+		m_lastReport = now;
+		ReportStatistics();
+	}
+}
+
+void FramePacer::WaitForNextFrame()
+{
+	if (m_mode != ePacingMode::e_TargetRate)
+	{
+		return;
+	}
+
+	SleepUntil(m_nextFrame);
+
+	// Keep to the schedule rather than the time the frame happened to start, so small errors don't
+	// add up. If a frame ran so long that it missed its slot, start the schedule again from now
+	m_nextFrame += m_framePeriod;
+
+	const Clock::time_point now = Clock::now();
+	if (m_nextFrame < now)
+	{
+		m_nextFrame = now + m_framePeriod;
+	}
+}
+
+void FramePacer::SleepUntil(const Clock::time_point deadline)
+{
+	// Sleep a millisecond at a time while there is clearly time for another one. A sleep counts as
+	// clearly fitting if it is within the mean plus one standard deviation of the recent sleeps, with
+	// the deviation held to at most one sleep
+	while (true)
+	{
+		const double remaining = to_seconds(deadline - Clock::now());
+		const double deviation = std::min(std::sqrt(m_sleepSquaredDifferences / static_cast<double>(m_sleepSamples)), to_seconds(SLEEP_QUANTUM));
+
+		if (remaining <= m_sleepMean + deviation)
+		{
+			break;
+		}
+
+		const Clock::time_point sleepStart = Clock::now();
+		std::this_thread::sleep_for(SLEEP_QUANTUM);
+		const double slept = to_seconds(Clock::now() - sleepStart);
+
+		// Welford's running mean and variance. Once the sample count stops growing the squared
+		// differences are scaled down to match, so they describe the last MAX_SLEEP_SAMPLES sleeps
+		// rather than adding up forever
+		if (m_sleepSamples == MAX_SLEEP_SAMPLES)
+		{
+			m_sleepSquaredDifferences *= static_cast<double>(MAX_SLEEP_SAMPLES - 1) / static_cast<double>(MAX_SLEEP_SAMPLES);
+		} else
+		{
+			++m_sleepSamples;
+		}
+
+		const double difference = slept - m_sleepMean;
+		m_sleepMean += difference / static_cast<double>(m_sleepSamples);
+		m_sleepSquaredDifferences += difference * (slept - m_sleepMean);
+	}
+
+	// Spin for whatever is left, it is too short to trust to the scheduler
+	while (Clock::now() < deadline)
+	{
+		std::this_thread::yield();
+	}
+}
+
+void FramePacer::ReportStatistics()
+{
+	if (m_recordedFrames == 0)
+	{
+		return;
+	}
+
+	m_sortedFrameTimes.assign(m_frameTimes.begin(), m_frameTimes.begin() + static_cast<std::ptrdiff_t>(m_recordedFrames));
+
+	float total = 0.f;
+	for (const float frameTime : m_sortedFrameTimes)
+	{
+		total += frameTime;
+	}
+	const float mean = total / static_cast<float>(m_recordedFrames);
+
+	// Frames are janky if they take noticeably longer than the target, or than usual without one
+	const float expected = m_mode == ePacingMode::e_TargetRate ? static_cast<float>(to_seconds(m_framePeriod)) * 1000.f : mean;
+	const auto jankyFrames = std::count_if(m_sortedFrameTimes.begin(), m_sortedFrameTimes.end(), [expected](const float frameTime)
+		{
+			return frameTime > expected * JANK_FACTOR;
+		});
+
+	const size_t percentile = std::min(m_recordedFrames - 1, m_recordedFrames * 99 / 100);
+	std::nth_element(m_sortedFrameTimes.begin(), m_sortedFrameTimes.begin() + static_cast<std::ptrdiff_t>(percentile), m_sortedFrameTimes.end());
+
+	LOG_INFO("{} frame times: mean {}ms, 99th percentile {}ms, {} janky frames",
+		m_name, mean, m_sortedFrameTimes[percentile], static_cast<int>(jankyFrames));
+}
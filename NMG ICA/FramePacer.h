@@ -0,0 +1,124 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/**
+ * \brief How the client decides when to start the next frame
+ */
+enum class ePacingMode : uint8_t
+{
+	// Start the next frame straight away
+	e_Uncapped,
+	// Sleep until the next frame is due at the target frame rate
+	e_TargetRate,
+	// The window waits for the display with vertical sync, so the pacer doesn't wait as well
+	e_DisplaySync
+};
+
+/**
+ * \brief Paces the client's main loop. At a target frame rate it sleeps away the spare time at the
+ * end of each frame, a millisecond at a time while it is sure not to oversleep, then spins for the
+ * last fraction of a millisecond so the next frame starts on time. How long a millisecond of sleep
+ * really takes is measured as it goes, so the spinning adapts to the timer of the machine.
+ * The pacer also works out how many fixed physics steps each frame has to run, so the simulation
+ * rate doesn't depend on the frame rate, and keeps frame time statistics that are logged now and then
+ */
+class FramePacer
+{
+public:
+	/**
+	 * \param name What the frames are for, written with the statistics
+	 * \param mode How to wait between frames
+	 * \param targetFrameRate The frames per second to aim for with ePacingMode::e_TargetRate
+	 * \param fixedStep The length of a physics step in seconds
+	 * \param maxCatchUp The most time the physics catches up on in one frame, so a long stall
+	 * doesn't make the next frame run hundreds of steps
+	 */
+	FramePacer(const char* name, ePacingMode mode, float targetFrameRate, float fixedStep, float maxCatchUp);
+
+	~FramePacer();
+
+	// Non-copyable, it changes the system timer resolution for as long as it is alive
+	FramePacer(const FramePacer& other) = delete;
+	FramePacer& operator=(const FramePacer& other) = delete;
+
+	/**
+	 * \brief Starts a frame, measuring how long the last one took and working out the physics steps
+	 */
+	void BeginFrame();
+
+	/**
+	 * \brief Waits until the next frame is due, call once the frame has been displayed
+	 */
+	void WaitForNextFrame();
+
+	/**
+	 * \return The time since the last frame started, in seconds
+	 */
+	[[nodiscard]] float FrameTime() const { return m_frameTime; }
+
+	/**
+	 * \return How many fixed physics steps this frame has to run
+	 */
+	[[nodiscard]] int PhysicsSteps() const { return m_physicsSteps; }
+
+	/**
+	 * \return How far into the next physics step the frame is, from 0 to 1, for interpolating
+	 */
+	[[nodiscard]] float StepFraction() const { return m_physicsAccumulator / m_fixedStep; }
+
+	/**
+	 * \return How the pacer waits between frames
+	 */
+	[[nodiscard]] ePacingMode Mode() const { return m_mode; }
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	const char* m_name;
+
+	ePacingMode m_mode;
+
+	// The time between frames at the target frame rate
+	Clock::duration m_framePeriod;
+
+	// When the current frame started, and when the next one is due
+	Clock::time_point m_frameStart;
+	Clock::time_point m_nextFrame;
+
+	float m_frameTime;
+
+	// The physics step, and the time that hasn't been simulated yet
+	float m_fixedStep;
+	float m_maxCatchUp;
+	float m_physicsAccumulator;
+	int m_physicsSteps;
+
+	// The running mean and variance of how long a one millisecond sleep takes, in seconds
+	double m_sleepMean;
+	double m_sleepSquaredDifferences;
+	int64_t m_sleepSamples;
+
+	// The most recent frame times in milliseconds, written round in a circle
+	std::vector<float> m_frameTimes;
+	size_t m_nextFrameTime;
+	size_t m_recordedFrames;
+
+	// Scratch space for working out the percentile, kept so reporting doesn't allocate
+	std::vector<float> m_sortedFrameTimes;
+
+	// When the statistics were last logged
+	Clock::time_point m_lastReport;
+
+	/**
+	 * \brief Sleeps and then spins until a point in time
+	 * \param deadline When to wake up
+	 */
+	void SleepUntil(Clock::time_point deadline);
+
+	/**
+	 * \brief Logs the mean, 99th percentile and amount of janky frames over the recent frames
+	 */
+	void ReportStatistics();
+};
@@ -1,4 +1,5 @@
 ﻿#pragma once
+#include <cstdint>
 #include <unordered_map>
 
 namespace globals
@@ -8,42 +9,114 @@ namespace globals
 		constexpr float k_carTrackSpeed = 300.f;
 		constexpr float k_carGrassSpeed = 50.f;
 		constexpr float k_carStartingRotation = 1.5708f;
+		constexpr float k_carTurnSpeed = 3.14f;
 		constexpr float k_carSpriteWidth = 20.f;
 		constexpr float k_carSpriteHeight = 34.f;
 
 		constexpr float k_carOriginX = 10.f;
 		constexpr float k_carOriginY = 17.f;
 
+		// The diameter of a circle that fully contains a car at any rotation, used to size the collision grid
+		constexpr float k_carBoundingDiameter = 40.f;
+
 	} // namespace cars
 
 	namespace game
 	{
 		constexpr int k_playerAmount = 4;
-		
-		constexpr int k_numCheckPoints = 11;
-		constexpr float k_checkPointWidth = 50.f;
-		constexpr float k_checkPointHeight = 150.f;
-
-		constexpr float k_aiDistanceThreshold = 100.f;
 
-		inline const sf::Vector2f k_checkPointColliderSize{ globals::game::k_checkPointWidth, globals::game::k_checkPointHeight };
+		// How far along the racing line ahead of itself the AI steers towards
+		constexpr float k_aiLookaheadDistance = 32.f;
 
 		constexpr int k_screenWidth = 1024;
 		constexpr int k_screenHeight = 768;
 		
 		constexpr int k_totalLaps = 3;
+
+		// The longest the server waits for packets before running a tick of the simulation
+		constexpr float k_serverTickTime = 0.05f;
 	}
 
+	namespace spectators
+	{
+		// The game server only takes a few spectators, meant for relays, so its sends don't grow
+		// with the audience. Everybody else watches through a relay
+		constexpr int k_maxServerSpectators = 2;
+
+		// The port relays take spectators on
+		constexpr unsigned short k_relayPort = 25566;
+
+		// How often the server sends spectators a keyframe of the whole race, in seconds
+		constexpr float k_keyframeInterval = 2.f;
+	} // namespace spectators
+
+	namespace matchmaking
+	{
+		// The longest the first player in a room waits for it to fill before the race starts anyway,
+		// with the server's AI driving the empty places on the grid, in seconds
+		constexpr float k_roomWaitTime = 30.f;
+
+		// The most players that can wait for the next room while a race is on, the rest are turned away
+		constexpr int k_maxQueuedPlayers = 8;
+
+		// How long the results stay up once a race is over before the room closes and the players
+		// waiting in the queue take the grid, in seconds
+		constexpr float k_resultsTime = 15.f;
+	} // namespace matchmaking
+
+	namespace sessions
+	{
+		// How long the server keeps the session of a player whose connection dropped mid race, in
+		// seconds. Their car waits on the track until they come back or the time runs out
+		constexpr float k_resumeGracePeriod = 30.f;
+
+		// How often a client whose connection dropped tries to resume its session, in seconds
+		constexpr float k_resumeRetryInterval = 1.f;
+
+		// The longest a client waits for the server to answer when it connects, in seconds
+		constexpr float k_connectionTimeout = 10.f;
+
+		// How long a new connection has to introduce itself before the server closes it, in seconds
+		constexpr float k_handshakeTimeout = 5.f;
+
+		// How often the server sends each session a heartbeat, and how long a session can stay quiet
+		// before the server counts it as gone, in seconds. Clients answer every heartbeat, so a dead
+		// peer is noticed even if TCP never reports it
+		constexpr float k_heartbeatInterval = 1.f;
+		constexpr float k_heartbeatTimeout = 5.f;
+
+		// The most messages the server acts on from one client in each window, the rest are dropped.
+		// Clients send their position 20 times a second
+		constexpr float k_rateLimitWindow = 1.f;
+		constexpr int k_rateLimitMessages = 60;
+
+		// How often a player asks the server the time to keep its clock in step, and how often the
+		// server logs the round trip time of every session, in seconds
+		constexpr float k_clockSyncInterval = 1.f;
+		constexpr float k_statsInterval = 10.f;
+	} // namespace sessions
+
+	namespace lag_compensation
+	{
+		// The furthest back the server looks when it judges a player's move against where the other
+		// cars were on that player's screen, in seconds. A client further behind than this is
+		// judged as if it were this far behind, so a bad connection can't reach further into the past
+		constexpr float k_maxRewind = 0.25f;
+	} // namespace lag_compensation
+
 
 	inline const std::string k_reservedServerUsername = "SERVER";
 
+	// The network ID of messages that come from the server rather than being about a player
+	constexpr uint16_t k_serverNetworkId = 0xFFFF;
+
 
 	/**
 	 * \brief Calculates the square magnitude of a given vector
 	 * \param v The vector to calculate
 	 * \return The Square Mag of the vector
 	 */
-	constexpr inline float sqr_magnitude(sf::Vector2f& v)
+	constexpr inline float sqr_magnitude(const sf::Vector2f& v)
 	{
 		return(v.x * v.x + v.y * v.y);
 	}
@@ -0,0 +1,112 @@
+#include "Hud.h"
+
+#include <iterator>
+
+#include "Globals.h"
+
+namespace
+{
+	constexpr unsigned WAITING_CHARACTER_SIZE = 60;
+	constexpr unsigned RACE_CHARACTER_SIZE = 30;
+
+	const sf::Vector2f LAPS_POSITION(730.f, 25.f);
+	const sf::Vector2f RACE_POSITION_POSITION(730.f, 75.f);
+
+	// The names of the places at the end of the race
+	const char* const PLACE_NAMES[]{ "1st: ", "2nd: ", "3rd: ", "4th: " };
+} // anonymous namespace
+
+Hud::Hud() :
+	m_font(nullptr),
+	m_shownLaps(-1),
+	m_shownPosition(-1),
+	m_shownPlayerCount(-1)
+{
+	m_waitingText.setString("Waiting for other players\nto connect...");
+	m_waitingText.setCharacterSize(WAITING_CHARACTER_SIZE);
+
+	m_lapsText.setCharacterSize(RACE_CHARACTER_SIZE);
+	m_lapsText.setPosition(LAPS_POSITION);
+
+	m_positionText.setCharacterSize(RACE_CHARACTER_SIZE);
+	m_positionText.setPosition(RACE_POSITION_POSITION);
+}
+
+void Hud::SetFont(const sf::Font& font)
+{
+	m_font = &font;
+
+	m_waitingText.setFont(font);
+	m_lapsText.setFont(font);
+	m_positionText.setFont(font);
+
+	// The waiting message is centred, which needs the font to measure it
+	const sf::FloatRect bounds = m_waitingText.getGlobalBounds();
+	m_waitingText.setPosition(
+		static_cast<float>(globals::game::k_screenWidth) / 2.f - bounds.width / 2,
+		static_cast<float>(globals::game::k_screenHeight) / 2.f - bounds.height
+	);
+}
+
+void Hud::SetRaceStatus(const int lapsCompleted, const int positionInRace, const int playerCount)
+{
+	if (lapsCompleted != m_shownLaps)
+	{
+		m_shownLaps = lapsCompleted;
+		m_lapsText.setString("Laps: " + std::to_string(lapsCompleted + 1) + " / " + std::to_string(globals::game::k_totalLaps));
+	}
+
+	if (positionInRace != m_shownPosition || playerCount != m_shownPlayerCount)
+	{
+		m_shownPosition = positionInRace;
+		m_shownPlayerCount = playerCount;
+		m_positionText.setString("Pos: " + std::to_string(positionInRace) + " / " + std::to_string(playerCount));
+	}
+}
+
+void Hud::SetResults(const std::vector<std::string>& placementOrder, const std::string& localUsername)
+{
+	m_resultTexts.clear();
+
+	for (int i = 0; i < static_cast<int>(placementOrder.size()); ++i)
+	{
+		const std::string place = i < static_cast<int>(std::size(PLACE_NAMES)) ? PLACE_NAMES[i] : "";
+
+		sf::Text& text = m_resultTexts.emplace_back();
+		if (m_font)
+		{
+			text.setFont(*m_font);
+		}
+		text.setCharacterSize(RACE_CHARACTER_SIZE);
+		text.setString(place + placementOrder[i]);
+
+		// Highlight the player with green text
+		text.setFillColor(placementOrder[i] == localUsername ? sf::Color::Green : sf::Color::White);
+
+		// Offset the text from each other
+		const sf::FloatRect bounds = text.getGlobalBounds();
+		text.setPosition(
+			static_cast<float>(globals::game::k_screenWidth) / 2.f - bounds.width / 2,
+			static_cast<float>(globals::game::k_screenHeight) / 2.f + static_cast<float>(i) * bounds.height + 20.f
+		);
+	}
+}
+
+void Hud::RenderWaiting(sf::RenderTarget& target) const
+{
+	target.draw(m_waitingText);
+}
+
+void Hud::RenderRace(sf::RenderTarget& target) const
+{
+	target.draw(m_lapsText);
+	target.draw(m_positionText);
+}
+
+void Hud::RenderResults(sf::RenderTarget& target) const
+{
+	for (const auto& text : m_resultTexts)
+	{
+		target.draw(text);
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <SFML/Graphics.hpp>
+
+/**
+ * \brief The text drawn over the game: the waiting message, the lap and position counters during
+ * the race and the final placements. Every piece of text is its own sf::Text that keeps its laid
+ * out glyphs between frames, and is only given a new string when the value it shows changes, so
+ * a frame where nothing changed doesn't allocate or lay out any text
+ */
+class Hud
+{
+public:
+	Hud();
+
+	/**
+	 * \brief Sets the font and lays out the text that never changes
+	 * \param font The font to write with, it must outlive the HUD
+	 */
+	void SetFont(const sf::Font& font);
+
+	/**
+	 * \brief Updates the race counters, the text is only rebuilt if one of the values changed
+	 * \param lapsCompleted The amount of laps the player has completed
+	 * \param positionInRace The player's place in the race, 1 being first
+	 * \param playerCount The amount of players in the race
+	 */
+	void SetRaceStatus(int lapsCompleted, int positionInRace, int playerCount);
+
+	/**
+	 * \brief Lays out the final placements
+	 * \param placementOrder The usernames from first place to last
+	 * \param localUsername The username of this client, which is highlighted
+	 */
+	void SetResults(const std::vector<std::string>& placementOrder, const std::string& localUsername);
+
+	/**
+	 * \param target The target to draw the waiting message to
+	 */
+	void RenderWaiting(sf::RenderTarget& target) const;
+
+	/**
+	 * \param target The target to draw the lap and position counters to
+	 */
+	void RenderRace(sf::RenderTarget& target) const;
+
+	/**
+	 * \param target The target to draw the final placements to
+	 */
+	void RenderResults(sf::RenderTarget& target) const;
+
+private:
+	const sf::Font* m_font;
+
+	// Shown until enough players have connected
+	sf::Text m_waitingText;
+
+	// The race counters, and the values they were last built for
+	sf::Text m_lapsText;
+	sf::Text m_positionText;
+	int m_shownLaps;
+	int m_shownPosition;
+	int m_shownPlayerCount;
+
+	// One line for each racer at the end of the game
+	std::vector<sf::Text> m_resultTexts;
+};
@@ -3,40 +3,29 @@
 #include <iostream>
 
 #include "Globals.h"
+#include "../Shared Files/TrackBake.h"
 
 Map::Map()
 {
 	// Load the image from the images folder
-	if (!m_image.loadFromFile("images/map.png"))
+	if (!m_texture.loadFromFile("images/map.png"))
 	{
 		std::cout << "Unable to load the background image!" << std::endl;
 	}
 
-	// Set the texture to be the data stored in the image
-	m_texture.loadFromImage(m_image);
-
-	const sf::Vector2f checkPointColliderSize{ globals::game::k_checkPointWidth, globals::game::k_checkPointHeight };
+	// Map the baked track, or bake it if it's missing or out of date
+	if (!track_bake::load_or_bake(m_track, "images/map.track", "images/map_track.txt", "images/map.png"))
+	{
+		std::cout << "Unable to load the track!" << std::endl;
+	}
 }
 
 void Map::CheckCollisions(Player& player) const
 {
 	// See if the player has gone off the track
 
-	const sf::Vector2f playerPosition = player.GetPosition();
-
-	const auto playerPixel = m_image.getPixel(
-		static_cast<unsigned>(playerPosition.x),
-		static_cast<unsigned>(playerPosition.y)
-	);
-
-	// Work out the colour of the pixel that the player is on top of and set their speed accordingly
-	if (playerPixel == sf::Color::Black || playerPixel == sf::Color::White)
-	{
-		player.SetSpeed(globals::cars::k_carTrackSpeed);
-	} else
-	{
-		player.SetSpeed(globals::cars::k_carGrassSpeed);
-	}
+	// Work out the surface that the player is on top of and set their speed accordingly
+	player.SetSpeed(SurfaceMask::SpeedOn(m_track.Surface().At(player.GetPosition())));
 }
 
 void Map::Render(sf::RenderWindow& window) const
@@ -1,5 +1,6 @@
 #pragma once
 #include "Player.h"
+#include "../Shared Files/TrackAsset.h"
 
 /**
  * \brief The map game object is the racetrack itself. It can detect if a player
@@ -23,9 +24,9 @@ public:
 	void Render(sf::RenderWindow& window) const;
 
 private:
-	// Loads an image file from the images folder
-	sf::Image m_image; 
+	// The baked track, which knows which parts of the map are track and which are grass
+	TrackAsset m_track;
 
-	// A wrapper for the image, allows it to be drawn onscreen
+	// The map image, allows it to be drawn onscreen
 	sf::Texture m_texture; 
 };
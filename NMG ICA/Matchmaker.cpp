@@ -0,0 +1,81 @@
+#include "Matchmaker.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../Shared Files/NetworkClock.h"
+
+Matchmaker::Matchmaker(const int roomSize, const float maxWait, const int queueCapacity) :
+	m_roomSize(roomSize),
+	m_maxWait(network_clock::from_seconds(maxWait)),
+	m_queueCapacity(static_cast<size_t>(queueCapacity)),
+	m_timesToRace(k_timeToRaceSamples, 0.f),
+	m_nextSample(0),
+	m_sampleCount(0)
+{
+	m_queue.reserve(m_queueCapacity);
+	m_sortedTimes.reserve(k_timeToRaceSamples);
+}
+
+int Matchmaker::Enqueue(const SessionHandle player)
+{
+	if (m_queue.size() == m_queueCapacity)
+	{
+		return 0;
+	}
+
+	m_queue.push_back(player);
+	return static_cast<int>(m_queue.size());
+}
+
+void Matchmaker::Remove(const SessionHandle player)
+{
+	const auto queued = std::find_if(m_queue.begin(), m_queue.end(), [player](const SessionHandle handle)
+		{
+			return handle.index == player.index && handle.generation == player.generation;
+		});
+
+	if (queued != m_queue.end())
+	{
+		m_queue.erase(queued);
+	}
+}
+
+SessionHandle Matchmaker::Pop()
+{
+	if (m_queue.empty())
+	{
+		return {};
+	}
+
+	const SessionHandle player = m_queue.front();
+	m_queue.erase(m_queue.begin());
+	return player;
+}
+
+bool Matchmaker::ShouldStartRoom(const int seated, const int64_t longestWait) const
+{
+	return seated >= m_roomSize || (seated > 0 && longestWait >= m_maxWait);
+}
+
+void Matchmaker::RecordTimeToRace(const int64_t timeToRace)
+{
+	m_timesToRace[m_nextSample] = static_cast<float>(static_cast<double>(timeToRace) / 1000000.0);
+	m_nextSample = (m_nextSample + 1) % k_timeToRaceSamples;
+	m_sampleCount = std::min(m_sampleCount + 1, k_timeToRaceSamples);
+}
+
+float Matchmaker::TimeToRacePercentile(const float percentile) const
+{
+	if (m_sampleCount == 0)
+	{
+		return 0.f;
+	}
+
+	m_sortedTimes.assign(m_timesToRace.begin(), m_timesToRace.begin() + m_sampleCount);
+
+	// The nearest rank, the smallest time that at least the percentile of the players waited no longer than
+	const int rank = std::clamp(static_cast<int>(std::ceil(percentile * static_cast<float>(m_sampleCount))) - 1, 0, m_sampleCount - 1);
+	std::nth_element(m_sortedTimes.begin(), m_sortedTimes.begin() + rank, m_sortedTimes.end());
+	return m_sortedTimes[rank];
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "SessionTable.h"
+
+/**
+ * \brief Decides when the server's room of players becomes a race, and keeps the players who arrive
+ * while the room is racing or full waiting in arrival order for the next one. A room starts as soon
+ * as it is full, or once its longest waiting player has waited long enough, with AI filling the
+ * empty places. It also keeps the time each player waited from asking to race to the race starting,
+ * so the percentiles of the time to race can be reported
+ */
+class Matchmaker
+{
+public:
+	/**
+	 * \param roomSize The amount of places on the grid
+	 * \param maxWait The longest a room waits to fill before it starts anyway, in seconds
+	 * \param queueCapacity The most players that can wait for the next room
+	 */
+	Matchmaker(int roomSize, float maxWait, int queueCapacity);
+
+	/**
+	 * \brief Adds a player to the back of the queue for the next room
+	 * \param player The player's session
+	 * \return The player's place in the queue counting from 1, 0 if the queue is full
+	 */
+	int Enqueue(SessionHandle player);
+
+	/**
+	 * \brief Takes a player out of the queue, for a player who left while waiting
+	 * \param player The player's session, nothing happens if it isn't queued
+	 */
+	void Remove(SessionHandle player);
+
+	/**
+	 * \return The player at the front of the queue, who is taken out of it, invalid if nobody is waiting
+	 */
+	[[nodiscard]] SessionHandle Pop();
+
+	/**
+	 * \return The amount of players waiting for the next room
+	 */
+	[[nodiscard]] int Waiting() const { return static_cast<int>(m_queue.size()); }
+
+	/**
+	 * \param seated The amount of players in the room
+	 * \param longestWait How long the room's longest waiting player has waited, in microseconds
+	 * \return True if the room should start racing, with AI in any empty places
+	 */
+	[[nodiscard]] bool ShouldStartRoom(int seated, int64_t longestWait) const;
+
+	/**
+	 * \brief Notes how long a player waited from asking to race to their race starting
+	 * \param timeToRace The wait in microseconds
+	 */
+	void RecordTimeToRace(int64_t timeToRace);
+
+	/**
+	 * \param percentile The percentile to work out, between 0 and 1
+	 * \return The time to race that the percentile of the recent players waited no longer than,
+	 * in seconds, 0 if nobody has raced yet
+	 */
+	[[nodiscard]] float TimeToRacePercentile(float percentile) const;
+
+	/**
+	 * \return The amount of recent times to race the percentiles are worked out from
+	 */
+	[[nodiscard]] int TimeToRaceSamples() const { return m_sampleCount; }
+
+private:
+	// The percentiles are worked out from this many of the most recent players
+	static constexpr int k_timeToRaceSamples = 256;
+
+	int m_roomSize;
+	int64_t m_maxWait;
+	size_t m_queueCapacity;
+
+	// The waiting players in arrival order. It holds a handful of players, so taking the front or
+	// someone from the middle is only a short move
+	std::vector<SessionHandle> m_queue;
+
+	// The recent times to race in seconds, a ring overwritten oldest first
+	std::vector<float> m_timesToRace;
+	int m_nextSample;
+	int m_sampleCount;
+
+	// Where the times are partly sorted to find a percentile, kept so the memory is reused
+	mutable std::vector<float> m_sortedTimes;
+};
@@ -1,9 +1,27 @@
 #include <iostream>
 #include "Client.h"
+#include "FramePacer.h"
 #include "Player.h"
+#include "../Shared Files/Logger.h"
 
-int main()
+namespace
 {
+	// The game thread reads input, handles the network and steps the physics at a steady rate. The physics
+	// runs at its own fixed rate whatever the update rate is
+	constexpr float UPDATE_RATE = 120.f;
+
+	// The render thread sleeps between frames to hold the frame rate, rather than spinning flat out or
+	// waiting on the display
+	constexpr ePacingMode RENDER_PACING_MODE = ePacingMode::e_TargetRate;
+	constexpr float RENDER_FRAME_RATE = 120.f;
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+	// Start with --spectate to watch the race through a relay rather than drive in it
+	const bool spectating = argc > 1 && std::string(argv[1]) == "--spectate";
+	const unsigned short port = spectating ? globals::spectators::k_relayPort : 25565;
+
 	bool clientCreated = false;
 	std::string username;
 
@@ -17,11 +35,14 @@ int main()
 
 		std::cin >> username;
 
-		client = Client::CreateClient(username, 25565);
+		client = Client::CreateClient(username, port, spectating);
 
 		if (client) clientCreated = true;
 	} while (!clientCreated);
 
+	// Each client gets its own log so that multiple clients can run on one machine
+	logging::Logger::Get().Start("client_" + username + ".log");
+
 
 	sf::Font gameFont;
 
@@ -31,11 +52,18 @@ int main()
 
 	sf::RenderWindow window(sf::VideoMode(globals::game::k_screenWidth, globals::game::k_screenHeight), "Racing Game: " + username);
 
-	sf::Clock clock;
+	// Hand the window over to the render thread, this thread keeps the events as they must be
+	// handled on the thread that made the window
+	window.setActive(false);
+	client->StartRendering(window, RENDER_PACING_MODE, RENDER_FRAME_RATE);
+
+	FramePacer pacer("Update", ePacingMode::e_TargetRate, UPDATE_RATE, car_physics::k_fixedStep, car_physics::k_maxCatchUp);
 
 	// run the program as long as the window is open
 	while (window.isOpen())
 	{
+		pacer.BeginFrame();
+
 		// check all the window's events that were triggered since the last iteration of the loop
 		sf::Event e{};
 
@@ -43,23 +71,22 @@ int main()
 		{
 			// "close requested" event: we close the window
 			if (e.type == sf::Event::Closed)
+			{
+				// Stop drawing before the window goes away
+				client->StopRendering();
 				window.close();
+			}
 		}
 
-		window.clear();
-
-		sf::Time time = clock.restart();
-		const float deltaTime = time.asSeconds();
-
 		// Only take input if the window has been clicked on - very useful for testing!
 		if (window.hasFocus())
 		{
-			client->Input(deltaTime);
+			client->Input();
 		}
 
-		client->Update(deltaTime);
-		client->Render(window);
+		client->Update(pacer.FrameTime(), pacer.PhysicsSteps());
 
-		window.display();
+		// Wait at the end of the update, so the input for the next one is read as late as possible
+		pacer.WaitForNextFrame();
 	}
 }
@@ -1,26 +1,22 @@
 ﻿#pragma once
 #include <SFML/Graphics.hpp>
 
+#include "../Shared Files/CarPhysics.h"
+
 /**
- * \brief The Player class holds all the information needed to control and draw the race cars for the game
+ * \brief The Player class holds all the information needed to control and draw the race cars for the game.
+ * The cars are drawn together by the CarBatch
  */
 class Player
 {
 public:
-	Player(); // Default constructor needed to compile for the unordered_map<>'s
-	Player(const sf::Texture& textureData);
+	Player();
 	
 	/**
-	 * \brief Updates the player object
-	 * \param deltaTime The time difference between frames for frame-rate independence
-	 */
-	void Update(float deltaTime);
-
-	/**
-	 * \brief Renders the player to the screen
-	 * \param window The RenderWindow to draw the map to
+	 * \brief Moves the player on by one fixed physics step
+	 * \param input The controls for the step
 	 */
-	void Render(sf::RenderWindow& window);
+	void Update(const car_physics::CarInput& input);
 
 	/**
 	 * \return The current position of the player
@@ -42,13 +38,6 @@ public:
 	 */
 	void SetColour(const sf::Color& colour);
 
-	
-	/**
-	 * \brief Changes the velocity of the player
-	 * \param dx The difference in the x axis for the velocity
-	 * \param dy The difference in the y axis for the velocity
-	 */
-	void ChangeVelocity(const float dx, const float dy);
 
 	/**
 	 * \return The current angle of the player
@@ -59,11 +48,6 @@ public:
 	 * \param angle The new angle, in Radians, to set the player
 	 */
 	void SetAngle(const float angle);
-	
-	/**
-	 * \param deltaAngle The change in angle, in Radians, of the player
-	 */
-	void ChangeAngle(const float deltaAngle);
 
 	/**
 	 * \return The current speed of the player
@@ -76,18 +60,9 @@ public:
 	void SetSpeed(const float speed);
 
 private:
-	// The sprite used to draw the player
-	sf::Sprite m_sprite;
-
-	// The current speed of the player
-	float m_speed;
-
-	// The current position of the player
-	sf::Vector2f m_position;
-
-	// The current velocity of the player
-	sf::Vector2f m_velocity;
+	// The colour the player's car is tinted
+	sf::Color m_colour;
 
-	// The current angle of the player
-	float m_angle;
+	// The position, angle and speed of the player
+	car_physics::CarState m_state;
 };
@@ -0,0 +1,60 @@
+#include "PlayerRegistry.h"
+
+bool PlayerRegistry::Add(const uint16_t networkId, const std::string& username)
+{
+	if (networkId >= m_indices.size())
+	{
+		m_indices.resize(static_cast<size_t>(networkId) + 1, -1);
+	}
+
+	if (m_indices[networkId] >= 0)
+	{
+		return false;
+	}
+
+	m_indices[networkId] = static_cast<int>(m_players.size());
+	m_players.emplace_back();
+	m_usernames.push_back(username);
+	m_networkIds.push_back(networkId);
+	++m_revision;
+
+	return true;
+}
+
+bool PlayerRegistry::Remove(const uint16_t networkId)
+{
+	if (networkId >= m_indices.size() || m_indices[networkId] < 0)
+	{
+		return false;
+	}
+
+	const int index = m_indices[networkId];
+	const int last = static_cast<int>(m_players.size()) - 1;
+
+	// Fill the gap with the last player so the array stays packed
+	if (index != last)
+	{
+		m_players[index] = std::move(m_players[last]);
+		m_usernames[index] = std::move(m_usernames[last]);
+		m_networkIds[index] = m_networkIds[last];
+		m_indices[m_networkIds[index]] = index;
+	}
+
+	m_players.pop_back();
+	m_usernames.pop_back();
+	m_networkIds.pop_back();
+	m_indices[networkId] = -1;
+	++m_revision;
+
+	return true;
+}
+
+Player* PlayerRegistry::Find(const uint16_t networkId)
+{
+	if (networkId >= m_indices.size() || m_indices[networkId] < 0)
+	{
+		return nullptr;
+	}
+
+	return &m_players[m_indices[networkId]];
+}
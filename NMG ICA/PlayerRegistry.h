@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Player.h"
+
+/**
+ * \brief Holds every player in the game on the client. The players are kept packed together in one
+ * array so rendering and updating walk contiguous memory, and a sparse array indexed by network ID
+ * points into it so finding a player is two array reads. The server hands out network IDs as small
+ * integers and reuses them, so they double as the handles the rest of the client keeps.
+ * Removing a player moves the last player into its place, so indices into the packed array are
+ * only valid until the next removal
+ */
+class PlayerRegistry
+{
+public:
+	PlayerRegistry() = default;
+
+	/**
+	 * \brief Adds a player, unless one already has the network ID
+	 * \param networkId The ID the server gave the player
+	 * \param username The username of the player
+	 * \return True if the player was added
+	 */
+	bool Add(uint16_t networkId, const std::string& username);
+
+	/**
+	 * \brief Removes a player, the last player is moved into its place
+	 * \param networkId The ID the server gave the player
+	 * \return True if there was a player to remove
+	 */
+	bool Remove(uint16_t networkId);
+
+	/**
+	 * \param networkId The ID the server gave the player
+	 * \return The player, or nullptr if there is no player with the network ID
+	 */
+	[[nodiscard]] Player* Find(uint16_t networkId);
+
+	/**
+	 * \return The amount of players
+	 */
+	[[nodiscard]] int Size() const { return static_cast<int>(m_players.size()); }
+
+	/**
+	 * \param index The index of the player in the packed array, from 0 to Size() - 1
+	 * \return The player
+	 */
+	[[nodiscard]] Player& PlayerAt(const int index) { return m_players[index]; }
+	[[nodiscard]] const Player& PlayerAt(const int index) const { return m_players[index]; }
+
+	/**
+	 * \param index The index of the player in the packed array, from 0 to Size() - 1
+	 * \return The username of the player
+	 */
+	[[nodiscard]] const std::string& UsernameAt(const int index) const { return m_usernames[index]; }
+
+	/**
+	 * \param index The index of the player in the packed array, from 0 to Size() - 1
+	 * \return The network ID of the player
+	 */
+	[[nodiscard]] uint16_t NetworkIdAt(const int index) const { return m_networkIds[index]; }
+
+	/**
+	 * \return A count that goes up every time a player is added or removed, so anything built
+	 * from the list of players knows when to rebuild
+	 */
+	[[nodiscard]] uint32_t Revision() const { return m_revision; }
+
+private:
+	// The players, packed together
+	std::vector<Player> m_players;
+
+	// The username and network ID of each player, indexed the same as m_players
+	std::vector<std::string> m_usernames;
+	std::vector<uint16_t> m_networkIds;
+
+	// The index in m_players of the player with each network ID, -1 for IDs that aren't in use
+	std::vector<int> m_indices;
+
+	// Bumped whenever the players change
+	uint32_t m_revision = 0;
+};
@@ -0,0 +1,95 @@
+#include "RaceRanking.h"
+
+#include <algorithm>
+
+RaceRanking::RaceRanking(const int capacity)
+{
+	m_order.reserve(capacity);
+	m_ranks.resize(capacity, 0);
+	m_reportedRanks.resize(capacity, -1);
+	m_changedCars.reserve(capacity);
+	m_changed.resize(capacity, 0);
+}
+
+void RaceRanking::Add(const int car)
+{
+	m_ranks[car] = static_cast<int>(m_order.size());
+	m_reportedRanks[car] = -1;
+	m_order.push_back(car);
+
+	MarkChanged(car);
+}
+
+void RaceRanking::Remove(const int car, const int movedCar)
+{
+	// Everyone behind the removed car moves up a place
+	const int rank = m_ranks[car];
+	m_order.erase(m_order.begin() + rank);
+
+	for (int i = rank; i < static_cast<int>(m_order.size()); ++i)
+	{
+		m_ranks[m_order[i]] = i;
+		MarkChanged(m_order[i]);
+	}
+
+	// Drop the removed car from the changed list, it won't be reported again
+	if (m_changed[car])
+	{
+		m_changedCars.erase(std::find(m_changedCars.begin(), m_changedCars.end(), car));
+		m_changed[car] = 0;
+	}
+
+	if (movedCar == -1)
+	{
+		return;
+	}
+
+	// The moved car takes over the removed car's index
+	m_ranks[car] = m_ranks[movedCar];
+	m_reportedRanks[car] = m_reportedRanks[movedCar];
+	m_order[m_ranks[car]] = car;
+
+	if (m_changed[movedCar])
+	{
+		*std::find(m_changedCars.begin(), m_changedCars.end(), movedCar) = car;
+		m_changed[movedCar] = 0;
+		m_changed[car] = 1;
+	}
+}
+
+void RaceRanking::Update(const int car, const float* progress)
+{
+	const float carProgress = progress[car];
+	int rank = m_ranks[car];
+
+	// Ties don't swap, so cars side by side don't flicker between places
+	while (rank > 0 && progress[m_order[rank - 1]] < carProgress)
+	{
+		SwapWithNext(--rank);
+	}
+
+	while (rank + 1 < static_cast<int>(m_order.size()) && progress[m_order[rank + 1]] > carProgress)
+	{
+		SwapWithNext(rank++);
+	}
+}
+
+void RaceRanking::SwapWithNext(const int rank)
+{
+	std::swap(m_order[rank], m_order[rank + 1]);
+
+	m_ranks[m_order[rank]] = rank;
+	m_ranks[m_order[rank + 1]] = rank + 1;
+
+	MarkChanged(m_order[rank]);
+	MarkChanged(m_order[rank + 1]);
+}
+
+void RaceRanking::MarkChanged(const int car)
+{
+	if (!m_changed[car])
+	{
+		m_changed[car] = 1;
+		m_changedCars.push_back(car);
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/**
+ * \brief Keeps the cars in race order, ordered by their progress value. The order only changes a
+ * little between position updates, so a car that moves is bubbled up or down past its neighbours
+ * rather than sorting everybody again. Cars whose place changed are remembered until the changes
+ * are flushed, which only reports the places that are different from the last flush
+ */
+class RaceRanking
+{
+public:
+	/**
+	 * \param capacity The most cars that can be ranked at once
+	 */
+	explicit RaceRanking(int capacity);
+
+	/**
+	 * \brief Adds a car in last place
+	 * \param car The index of the car, which must be the next index after the cars already ranked
+	 */
+	void Add(int car);
+
+	/**
+	 * \brief Removes a car, mirroring CarStateStore::Remove where the last car is moved into its place
+	 * \param car The index of the car to remove
+	 * \param movedCar The index the moved car used to have, -1 if no car was moved
+	 */
+	void Remove(int car, int movedCar);
+
+	/**
+	 * \brief Moves a car to its new place after its progress has changed
+	 * \param car The index of the car that moved
+	 * \param progress The progress of every car, indexed by car
+	 */
+	void Update(int car, const float* progress);
+
+	/**
+	 * \brief Reports every car whose place is different from the last flush
+	 * \tparam OnRankChanged A callable taking the index of a car and its new place, 0 being first
+	 * \param onRankChanged Called once for each car that changed place
+	 */
+	template<typename OnRankChanged>
+	void FlushChanges(OnRankChanged&& onRankChanged)
+	{
+		for (const int car : m_changedCars)
+		{
+			m_changed[car] = 0;
+
+			if (m_ranks[car] != m_reportedRanks[car])
+			{
+				m_reportedRanks[car] = m_ranks[car];
+				onRankChanged(car, m_ranks[car]);
+			}
+		}
+		m_changedCars.clear();
+	}
+
+	/**
+	 * \return The cars from first place to last
+	 */
+	[[nodiscard]] const std::vector<int>& Order() const { return m_order; }
+
+	/**
+	 * \param car The index of a ranked car
+	 * \return The car's place, 0 being first
+	 */
+	[[nodiscard]] int Rank(const int car) const { return m_ranks[car]; }
+
+private:
+	// The cars from first place to last
+	std::vector<int> m_order;
+
+	// The place of each car, indexed by car
+	std::vector<int> m_ranks;
+
+	// The place each car was last reported in, -1 if it hasn't been reported yet
+	std::vector<int> m_reportedRanks;
+
+	// The cars that may have changed place since the last flush, and a flag per car so that
+	// each is only listed once
+	std::vector<int> m_changedCars;
+	std::vector<uint8_t> m_changed;
+
+	/**
+	 * \brief Swaps the cars in two neighbouring places
+	 * \param rank The higher of the two places
+	 */
+	void SwapWithNext(int rank);
+
+	/**
+	 * \param car A car to add to the list of changed cars
+	 */
+	void MarkChanged(int car);
+};
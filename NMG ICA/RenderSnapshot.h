@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <SFML/Graphics.hpp>
+
+/**
+ * \brief Which screen the client is showing
+ */
+enum class eGamePhase : uint8_t
+{
+	e_Waiting,
+	e_Racing,
+	e_Results
+};
+
+/**
+ * \brief Where a car is drawn
+ */
+struct CarSnapshot
+{
+	sf::Vector2f position;
+	float angle = 0.f;
+	sf::Color colour;
+};
+
+/**
+ * \brief Everything the render thread needs to draw a frame, published by the game thread
+ * after each update. The render thread only ever reads it
+ */
+struct RenderSnapshot
+{
+	eGamePhase phase = eGamePhase::e_Waiting;
+
+	// Spectators have no laps or place of their own to show
+	bool spectating = false;
+
+	// Every player's car, and their names in the same order
+	std::vector<CarSnapshot> cars;
+	std::vector<std::string> usernames;
+
+	// The PlayerRegistry::Revision the names were copied from, they are only copied again when it changes
+	uint32_t labelRevision = 0;
+
+	int lapsCompleted = 0;
+	int positionInRace = 0;
+
+	// The usernames from first place to last, once the game is over
+	std::vector<std::string> placementOrder;
+};
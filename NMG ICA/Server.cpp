@@ -2,9 +2,11 @@
 
 #include <iostream>
 #include <algorithm>
-#include <SFML/Graphics/RectangleShape.hpp>
+#include "../Shared Files/CarPhysics.h"
 #include "../Shared Files/Data.h"
-#include <algorithm>
+#include "../Shared Files/Logger.h"
+#include "../Shared Files/TrackBake.h"
+#include "Collision.h"
 
 // constants that exist within Server.cpp and don't need to be defined in
 // globals.h
@@ -18,97 +20,34 @@ namespace
 		sf::Color(255, 255, 0)
 	};
 
-	// The starting positions of the clients
-	const std::array<sf::Vector2f, globals::game::k_playerAmount> STARTING_POSITIONS{
-		sf::Vector2f(779.f, 558.f),
-		sf::Vector2f(779.f, 616.f),
-		sf::Vector2f(772.f, 558.f),
-		sf::Vector2f(722.f, 616.f)
-	};
+	// A slot for every place on the grid, player or bot, every player waiting for the next room and
+	// every spectator, and one for the connection being accepted
+	constexpr int SESSION_CAPACITY = globals::game::k_playerAmount + globals::matchmaking::k_maxQueuedPlayers +
+		globals::spectators::k_maxServerSpectators + 1;
 
-	// The positions of the 11 checkpoints that are placed around the map to ensure that a
-	// proper lap has been completed
-	const std::array<sf::FloatRect, globals::game::k_numCheckPoints> LEVEL_CHECKPOINTS{
-		sf::FloatRect({ 803.f, 523.f }, globals::game::k_checkPointColliderSize),
-		sf::FloatRect({ 846.f, 373.f }, globals::game::k_checkPointColliderSize),
-		sf::FloatRect({ 681.f, 313.f }, globals::game::k_checkPointColliderSize),
-	sf::FloatRect({511.f, 11.f}, globals::game::k_checkPointColliderSize),
-	sf::FloatRect({ 384.f, 313.f }, globals::game::k_checkPointColliderSize),
-	sf::FloatRect({ 167.f, 37.f }, globals::game::k_checkPointColliderSize),
-	sf::FloatRect({ 17.f, 400.f }, {globals::game::k_checkPointHeight, globals::game::k_checkPointWidth}),
-	sf::FloatRect({ 132.f, 597.f }, globals::game::k_checkPointColliderSize),
-	sf::FloatRect({ 282.f, 584.f }, globals::game::k_checkPointColliderSize),
-	sf::FloatRect({ 434.f, 489.f }, globals::game::k_checkPointColliderSize),
-	sf::FloatRect({ 642.f, 508.f }, globals::game::k_checkPointColliderSize),
-	};
+	// The resolution of the session timers, in seconds
+	constexpr float TIMER_TICK = 0.01f;
 
-	/**
-	 * \brief A helper function for Server::WorkOutTrackPlacements, compares two clients to see who
-	 * has completed the most laps
-	 * \param a The first client
-	 * \param b The second client
-	 * \return True if a has completed more laps than b
-	 */
-	static bool compare_by_lap(std::unique_ptr<ClientSnapshot>& a, std::unique_ptr<ClientSnapshot>& b)
-	{
-		return a->lapsCompleted > b->lapsCompleted;
-	}
+	// The length of a server tick in microseconds, a fixed physics step
+	constexpr int64_t TICK_LENGTH = network_clock::from_seconds(car_physics::k_fixedStep);
 
-	/**
-	 * \brief A helper function for Server::WorkOutTrackPlacements, compares two clients to see who
-	 * has passed the most checkpoints if their laps are the same
-	 * \param a The first client
-	 * \param b The second client
-	 * \return True if a has passed more checkpoints than b
-	 */
-	static bool compare_by_check_points(std::unique_ptr<ClientSnapshot>& a, std::unique_ptr<ClientSnapshot>& b)
-	{
-		// Only compare checkpoints if the laps are the same
-		if (a->lapsCompleted == b->lapsCompleted)
-		{
-			// Find the index of the highest lap completed
-			const int aHighestCheckPoint = a->HighestCheckPointPassed();
-			const int bHighestCheckPoint = b->HighestCheckPointPassed();
-			return aHighestCheckPoint > bHighestCheckPoint;
-		}
-		return false;
-	}
+	// A client with more than this waiting to be sent has stopped reading, anything more for it is
+	// dropped until it catches up or its heartbeats time out
+	constexpr size_t MAX_UNSENT_BYTES = 64 * 1024;
 
 	/**
-	 * \brief A helper function for Server::WorkOutTrackPlacements, compares two clients to see who
-	 * out of the two is closest to their checkpoints if the laps and highest checkpoint passed is the
-	 * same
-	 * \param a The first client
-	 * \param b The second client
-	 * \return True if a is closer to the next checkpoint than b
+	 * \param role The role of a session
+	 * \return True if sessions with the role have a car in the race
 	 */
-	static bool compare_by_distance(std::unique_ptr<ClientSnapshot>& a, std::unique_ptr<ClientSnapshot>& b)
+	bool is_racer(const eSessionRole role)
 	{
-		if (a->lapsCompleted == b->lapsCompleted && a->HighestCheckPointPassed() == b->HighestCheckPointPassed())
-		{
-			// Calculate the Distance to the next checkpoint
-			const int highestCheckPoint = a->HighestCheckPointPassed();
-
-			sf::Vector2f nextCheckpointPosition;
-
-			if (highestCheckPoint == 5)
-				nextCheckpointPosition = sf::Vector2f(LEVEL_CHECKPOINTS[highestCheckPoint + 1].left, LEVEL_CHECKPOINTS[highestCheckPoint].top);
-			else
-				nextCheckpointPosition = sf::Vector2f(LEVEL_CHECKPOINTS[0].left, LEVEL_CHECKPOINTS[0].top);
-
-			// Find the distance to the next checkpoint
-			sf::Vector2f aC = nextCheckpointPosition - a->position;
-			sf::Vector2f bC = nextCheckpointPosition - b->position;
-
-			// Find the magnitude of the vectors
-			const float magAC = globals::sqr_magnitude(aC);
-			const float magBC = globals::sqr_magnitude(bC);
-
-			return magAC > magBC;
-
-		}
-		return false;
+		return role == eSessionRole::e_Player || role == eSessionRole::e_Parked || role == eSessionRole::e_Bot;
 	}
+
+	// Where the server finds the track, relative to the server project
+	const std::string TRACK_ASSET_PATH = "../NMG ICA/images/map.track";
+	const std::string TRACK_DESCRIPTION_PATH = "../NMG ICA/images/map_track.txt";
+	const std::string MAP_IMAGE_PATH = "../NMG ICA/images/map.png";
 } // anonymous namespace
 
 std::unique_ptr<Server> Server::CreateServer(const unsigned short port)
@@ -125,8 +64,28 @@ std::unique_ptr<Server> Server::CreateServer(const unsigned short port)
 }
 
 Server::Server() :
-	m_gameInProgress(false)
+	m_sessions(SESSION_CAPACITY),
+	m_timers(TIMER_TICK, static_cast<size_t>(SESSION_CAPACITY) * static_cast<size_t>(eSessionTimer::e_Count)),
+	m_keyframeTimer(0.f),
+	m_startTime(network_clock::now()),
+	m_statsTimer(0.f),
+	m_matchmaker(globals::game::k_playerAmount, globals::matchmaking::k_roomWaitTime, globals::matchmaking::k_maxQueuedPlayers),
+	m_raceOverAt(-1),
+	m_cars(globals::game::k_playerAmount),
+	m_history(globals::game::k_playerAmount),
+	m_aiDrivers(globals::game::k_playerAmount),
+	m_ranking(globals::game::k_playerAmount),
+	m_carSurfaces(globals::game::k_playerAmount, eSurfaceType::e_Track),
+	m_stepStartPositions(globals::game::k_playerAmount),
+	m_physicsAccumulator(0.f),
+	m_gameInProgress(false),
+	m_collisionGrid(
+		globals::cars::k_carBoundingDiameter,
+		static_cast<float>(globals::game::k_screenWidth),
+		static_cast<float>(globals::game::k_screenHeight)
+	)
 {
+	m_readySessions.reserve(SESSION_CAPACITY);
 }
 
 bool Server::Initialise(const unsigned short port)
@@ -142,6 +101,19 @@ bool Server::Initialise(const unsigned short port)
 	// Add the listener to the selector
 	m_socketSelector.add(m_listener);
 
+	// Map the baked track, or bake it if it's missing or out of date
+	if (!track_bake::load_or_bake(m_track, TRACK_ASSET_PATH, TRACK_DESCRIPTION_PATH, MAP_IMAGE_PATH))
+	{
+		std::cout << "Unable to load the track" << std::endl;
+		return false;
+	}
+
+	if (m_track.SpawnPointCount() < globals::game::k_playerAmount)
+	{
+		std::cout << "The track doesn't have a starting place for every player" << std::endl;
+		return false;
+	}
+
 	std::cout << "Server is listening to port " << port << ", waiting for connections... " << std::endl;
 	return true;
 }
@@ -151,469 +123,1409 @@ void Server::CheckForNewClients()
 	// See if the socket selector is ready to accept a new TCP socket
 	if (m_socketSelector.isReady(m_listener))
 	{
-		// Find the next available colour for the players
-		sf::Color colour = CAR_COLOURS[m_connectedClients.size()];
+		// Take a free slot for the connection, its socket is reused from the last session in the slot
+		const SessionHandle handle = m_sessions.Acquire();
+		ClientSnapshot* newClient = m_sessions.Get(handle);
 
-		// Find the next available starting position for the players
-		sf::Vector2f startingPosition = STARTING_POSITIONS[m_connectedClients.size()];
+		if (!newClient)
+		{
+			// Every slot is taken, so take the connection just to close it again
+			sf::TcpSocket overflowSocket;
+			m_listener.accept(overflowSocket);
+
+			LOG_WARNING("There is no room for another session, rejecting a new connection");
+			return;
+		}
 
-		// Create a new connection
-		auto* newClient = new ClientSnapshot(startingPosition, globals::cars::k_carStartingRotation);
-		if (m_listener.accept(*newClient->socket) == sf::Socket::Done)
+		if (m_listener.accept(*newClient->socket) != sf::Socket::Done)
 		{
-			sf::Packet inPacket;
-			TcpDataPacket inData;
+			LOG_WARNING("A client had an error connecting");
+			RemoveSession(handle);
+			return;
+		}
 
-			if (newClient->socket->receive(inPacket) == sf::Socket::Done)
-			{
-				inPacket >> inData;
-			}
+		// Don't hold up the tick waiting for the client to introduce itself, its first message is
+		// read when it arrives. A client that never sends one, or only sends part of it, is closed
+		// by the handshake timer
+		newClient->socket->setBlocking(false);
+		m_socketSelector.add(*newClient->socket);
+		StartTimer(handle, *newClient, eSessionTimer::e_Handshake, globals::sessions::k_handshakeTimeout);
+	}
+}
 
-			if (m_connectedClients.size() < globals::game::k_playerAmount)
-			{
-				if (inData.m_type == eDataPacketType::e_FirstConnection)
-				{
-					if (!IsUsernameTaken(inData.m_userName) && inData.m_userName != globals::k_reservedServerUsername)
-					{
-						// To tell the client that they are successful
-						sf::Packet outPacket;
-
-						TcpDataPacket outData{
-							eDataPacketType::e_UserNameConfirmation,
-							globals::k_reservedServerUsername,
-							startingPosition.x,
-							startingPosition.y,
-							globals::cars::k_carStartingRotation,
-							colour
-						};
-
-						// Add the new client to the selector - this means we can update all clients
-						m_socketSelector.add(*newClient->socket);
-
-						std::cout << inData.m_userName << " has connected to the server" << std::endl;
-
-						newClient->username = inData.m_userName;
-
-						m_connectedClients.emplace_back(newClient);
-
-						outPacket << outData;
-
-						newClient->socket->send(outPacket);
-
-						if(!BroadcastMessage({
-							eDataPacketType::e_NewClient,
-							globals::k_reservedServerUsername,
-							startingPosition.x,
-							startingPosition.y,
-							globals::cars::k_carStartingRotation,
-							colour }))
-						{
-							std::cout << "Failed to broadcast the new client to the connected clients" << std::endl;
-						}
-					} else
-					{
-						std::cout << "A CLIENT WITH THE USERNAME: " << inData.m_userName << " ALREADY EXISTS..." << std::endl;
+void Server::ReceiveIntroduction(const SessionHandle handle, ClientSnapshot& newClient)
+{
+	sf::Packet inPacket;
+	const sf::Socket::Status status = newClient.socket->receive(inPacket);
 
-						sf::Packet usernameRejectionPkt;
-						TcpDataPacket usernameRejectionData(eDataPacketType::e_UserNameRejection, globals::k_reservedServerUsername);
-						usernameRejectionPkt << usernameRejectionData;
+	if (status == sf::Socket::NotReady || status == sf::Socket::Partial)
+	{
+		// Only part of the message has arrived, the socket keeps it until the rest comes
+		return;
+	}
 
-						newClient->socket->send(usernameRejectionPkt);
-						delete newClient;
-					}
-				}
-			} else
-			{
-				std::cout << "MAXIMUM AMOUNT OF CLIENTS CONNECTED" << std::endl;
+	if (status != sf::Socket::Done)
+	{
+		LOG_WARNING("A client disconnected before introducing itself");
+		RemoveSession(handle);
+		return;
+	}
+
+	TcpDataPacket inData;
+	inPacket >> inData;
 
-				sf::Packet maxClientMessagePkt;
-				const TcpDataPacket maximumClientMessage(eDataPacketType::e_MaxPlayers, "SERVER");
-				maxClientMessagePkt << maximumClientMessage;
+	m_timers.Cancel(newClient.timers[static_cast<size_t>(eSessionTimer::e_Handshake)]);
+
+	if (inData.m_type == eDataPacketType::e_SpectatorConnection)
+	{
+		// Spectators don't take a player's place
+		newClient.username = inData.m_userName;
+		AddSpectator(handle);
+	} else if (inData.m_type == eDataPacketType::e_ResumeSession)
+	{
+		// A parked session already has its place in the race
+		ResumeSession(handle, inData);
+	} else if (inData.m_type == eDataPacketType::e_FirstConnection)
+	{
+		if (!IsUsernameTaken(inData.m_userName) && inData.m_userName != globals::k_reservedServerUsername)
+		{
+			newClient.username = inData.m_userName;
+			newClient.joinedAt = ServerTime();
 
-				newClient->socket->send(maxClientMessagePkt);
-				delete newClient;
+			// Take a place in the room straight away if it is still forming and nobody is waiting
+			// ahead, otherwise wait for the next room
+			if (!m_gameInProgress && m_cars.Size() < globals::game::k_playerAmount && m_matchmaker.Waiting() == 0)
+			{
+				SeatPlayer(handle, newClient);
+			} else
+			{
+				QueuePlayer(handle, newClient);
 			}
 		} else
 		{
-			std::cout << "A client had an error connecting..." << std::endl;
-			delete newClient;
-		}
-	}
-}
+			LOG_INFO("A client with the username {} already exists", inData.m_userName);
 
-bool Server::CheckGameOver()
-{
-	// See if every racer has won
-	bool gameOver = true;
-	for (const auto& racer : m_connectedClients)
-	{
-		if (!racer->raceCompleted)
-		{
-			gameOver = false;
+			sf::Packet usernameRejectionPkt;
+			TcpDataPacket usernameRejectionData(eDataPacketType::e_UserNameRejection, globals::k_reservedServerUsername);
+			usernameRejectionPkt << usernameRejectionData;
+
+			SendPacket(newClient, usernameRejectionPkt);
+			RemoveSession(handle);
 		}
+	} else
+	{
+		LOG_WARNING("A client connected without introducing itself");
+		RemoveSession(handle);
 	}
-
-	return gameOver;
 }
 
-void Server::CheckCollisionsBetweenClients()
+sf::Vector2f Server::PlaceOnGrid(ClientSnapshot& racer)
 {
-	// Start two loops to compare the clients to each other
-	for (auto& client : m_connectedClients)
-	{
-		for (auto& otherClient : m_connectedClients)
-		{
-			// Ensure the clients aren't the same by checking their unique identifier
-			if (client->username != otherClient->username)
-			{
-				// Calculate their distance from each other
-				float dx = client->position.x - otherClient->position.x;
-				float dy = client->position.y - otherClient->position.y;
+	// Find the next available colour and starting position for the racer, the parked sessions
+	// keep theirs
+	racer.gridSlot = FindFreeGridSlot();
+	const sf::Vector2f startingPosition = m_track.GetSpawnPoint(racer.gridSlot);
 
-				bool collisionOccurred = false;
+	racer.networkId = FindFreeNetworkId();
+	racer.colour = CAR_COLOURS[racer.gridSlot];
+	racer.car = m_cars.Add(startingPosition, globals::cars::k_carStartingRotation);
 
-				// While the magnitude of their vector distance is greater than the threshold...
-				while (dx * dx + dy * dy < 8 * 10.f * 17.f)
-				{
-					// Set the flag
-					collisionOccurred = true;
-
-					// Try to resolve the collision
-					client->position.x += dx / 10.f;
-					client->position.x += dy / 10.f;
-					otherClient->position.x -= dx / 10.f;
-					otherClient->position.x -= dy / 10.f;
-					dx = client->position.x - otherClient->position.x;
-					dy = client->position.y - otherClient->position.y;
-
-					// See if it is resolved
-					if (static_cast<int>(dx) == 0 && static_cast<int>(dy) == 0)
-						break;
-				}
+	m_carOwners.push_back(&racer);
+	m_ranking.Add(racer.car);
+	m_history.Reset(racer.car, ServerTime(), startingPosition, globals::cars::k_carStartingRotation);
 
-				// If a collision occurred and was resolved, update the clients
-				if (collisionOccurred)
-				{
-					if(!SendMessage({ eDataPacketType::e_CollisionData, client->username, client->position, otherClient->username }, client->username))
-					{
-						std::cout << "Failed to send collision data to " << client->username << std::endl;
-					}
+	return startingPosition;
+}
 
-					if(!SendMessage({ eDataPacketType::e_CollisionData, otherClient->username, otherClient->position, client->username }, otherClient->username))
-					{
-						std::cout << "Failed to send collision data to " << client->username << std::endl;
-					}
-				}
-			}
-		}
-	}
+TcpDataPacket Server::MakeNewClientMessage(const ClientSnapshot& racer) const
+{
+	TcpDataPacket newClientData{
+		eDataPacketType::e_NewClient,
+		racer.username,
+		m_cars.x[racer.car],
+		m_cars.y[racer.car],
+		m_cars.angle[racer.car],
+		racer.colour
+	};
+	newClientData.m_networkId = racer.networkId;
+	return newClientData;
 }
 
-void Server::WorkOutTrackPlacements()
+void Server::SeatPlayer(const SessionHandle handle, ClientSnapshot& player)
 {
-	// Find out the previous positions
-	std::vector<std::string> previousPositions;
+	player.role = eSessionRole::e_Player;
+	player.resumeToken = MakeResumeToken();
 
-	for (const auto& client : m_connectedClients)
-	{
-		previousPositions.emplace_back(client->username);
-	}
+	const sf::Vector2f startingPosition = PlaceOnGrid(player);
+
+	LOG_INFO("{} has joined the room", player.username);
+
+	// To tell the client that they are successful
+	TcpDataPacket outData{
+		eDataPacketType::e_UserNameConfirmation,
+		globals::k_reservedServerUsername,
+		startingPosition.x,
+		startingPosition.y,
+		globals::cars::k_carStartingRotation,
+		player.colour
+	};
+	outData.m_networkId = player.networkId;
+	outData.m_resumeToken = player.resumeToken;
 
-	// STEP 1 - CHECK THE LAPS OF THE PLAYERS
-	std::sort(m_connectedClients.begin(), m_connectedClients.end(), compare_by_lap);
+	sf::Packet outPacket;
+	outPacket << outData;
 
-	// STEP 2 - CHECK WHICH CHECKPOINTS THEY HAVE PASSED
-	std::sort(m_connectedClients.begin(), m_connectedClients.end(), compare_by_check_points);
+	SendPacket(player, outPacket);
 
-	// STEP 3 - CHECK DISTANCE BETWEEN THEM AND THE NEXT CHECKPOINT
-	std::sort(m_connectedClients.begin(), m_connectedClients.end(), compare_by_distance);
+	StartHeartbeats(handle, player);
 
-	// STEP 4 - SEE IF THE POSITIONS HAVE CHANGED
-	bool positionsChanged = false;
-	for (int i = 0; i < static_cast<int>(previousPositions.size()); ++i)
+	// Introduce the cars already on the grid, then introduce the new player to everybody
+	for (int car = 0; car < m_cars.Size(); ++car)
 	{
-		if (m_connectedClients[i]->username != previousPositions[i])
+		if (car == player.car)
 		{
-			positionsChanged = true;
+			continue;
 		}
-	}
 
-	if (positionsChanged)
-	{
-		// STEP 5 - TELL THE CLIENTS WHICH PLACE THEY ARE IN
-		for (int i = 0; i < static_cast<int>(m_connectedClients.size()); ++i)
+		sf::Packet existingPkt;
+		existingPkt << MakeNewClientMessage(*m_carOwners[car]);
+		if (!SendPacket(player, existingPkt))
 		{
-			std::cout << "\tPosition " << i + 1 << " : " << m_connectedClients[i]->username << std::endl;
-			if(!SendMessage({ eDataPacketType::e_Overtaken, globals::k_reservedServerUsername, i + 1 }, m_connectedClients[i]->username))
-			{
-				std::cout << "Failed to send a message to " << m_connectedClients[1]->username << std::endl;
-			}
+			LOG_WARNING("Failed to tell {} about {}", player.username, m_carOwners[car]->username);
 		}
 	}
 
+	if(!BroadcastMessage(MakeNewClientMessage(player)))
+	{
+		LOG_WARNING("Failed to broadcast the new client to the connected clients");
+	}
 }
 
-void Server::AIMovement(const float deltaTime, ClientSnapshot& client) const
+void Server::QueuePlayer(const SessionHandle handle, ClientSnapshot& player)
 {
-	// Choose the AI's next checkpoint
-	const sf::Vector2f target(
-		LEVEL_CHECKPOINTS[client.nextAICheckpoint].left + globals::game::k_checkPointWidth / 2.f,
-		LEVEL_CHECKPOINTS[client.nextAICheckpoint].top + globals::game::k_checkPointHeight / 2.f
-	);
+	const int place = m_matchmaker.Enqueue(handle);
+	if (place == 0)
+	{
+		LOG_INFO("The queue for the next room is full, rejecting {}", player.username);
 
-	// Calculate their rotation to the target
-	const float beta = client.angle - atan2(target.x - client.position.x, -target.y + client.position.y);
+		sf::Packet maxClientMessagePkt;
+		const TcpDataPacket maximumClientMessage(eDataPacketType::e_MaxPlayers, globals::k_reservedServerUsername);
+		maxClientMessagePkt << maximumClientMessage;
 
-	if (sin(beta) < 0)
-	{
-		client.angle += 3.14f * deltaTime;
-	} else
-	{
-		client.angle -= 3.14f * deltaTime;
+		SendPacket(player, maxClientMessagePkt);
+		RemoveSession(handle);
+		return;
 	}
 
-	// Move toward the target
-	client.position.x += sin(client.angle) * globals::cars::k_carTrackSpeed * deltaTime;
-	client.position.y -= cos(client.angle) * globals::cars::k_carTrackSpeed * deltaTime;
+	player.role = eSessionRole::e_Queued;
+
+	LOG_INFO("{} is waiting for the next room, {} in the queue", player.username, place);
 
-	sf::Vector2f direction = target - client.position;
+	sf::Packet queuedPkt;
+	queuedPkt << TcpDataPacket(eDataPacketType::e_Queued, globals::k_reservedServerUsername, place);
+	SendPacket(player, queuedPkt);
 
-	// See if the client is close enought to the checkpoint
-	if (globals::sqr_magnitude(direction) <
-		globals::game::k_aiDistanceThreshold * globals::game::k_aiDistanceThreshold)
+	// Queued players are kept alive the same as everyone else while they wait
+	StartHeartbeats(handle, player);
+}
+
+bool Server::AddBot()
+{
+	const SessionHandle handle = m_sessions.Acquire();
+	ClientSnapshot* bot = m_sessions.Get(handle);
+	if (!bot)
 	{
-		// If the threshold was met, increment the counter
-		client.nextAICheckpoint++;
-		if (client.nextAICheckpoint == globals::game::k_numCheckPoints)
-		{
-			// Reset if all checkpoints were reached
-			client.nextAICheckpoint = 0;
-		}
+		LOG_WARNING("There is no room for another AI driver");
+		return false;
 	}
 
-	// Update the clients on the AI Move
-	if(!BroadcastMessage({ eDataPacketType::e_UpdatePosition, client.username, client.position.x, client.position.y, client.angle }))
+	// Bots have no connection, so they never go in the selector or get timers
+	bot->role = eSessionRole::e_Bot;
+	bot->username = MakeBotName();
+
+	PlaceOnGrid(*bot);
+	m_cars.aiDriven[bot->car] = 1;
+
+	if(!BroadcastMessage(MakeNewClientMessage(*bot)))
 	{
-		std::cout << "Failed to broadcast the message to all clients" << std::endl;
+		LOG_WARNING("Failed to tell the players about {}", bot->username);
 	}
+	return true;
 }
 
-int Server::FindClientIndex(const std::string& username) const
+std::string Server::MakeBotName() const
 {
-	for (int i = 0; i < static_cast<int>(m_connectedClients.size()); ++i)
+	for (int number = 1; ; ++number)
 	{
-		if (m_connectedClients[i]->username == username)
+		std::string name = "AI " + std::to_string(number);
+		if (!IsUsernameTaken(name))
 		{
-			return i;
+			return name;
 		}
 	}
-	return -1;
 }
 
-bool Server::IsUsernameTaken(const std::string& username) const
+void Server::Matchmake()
 {
-	const bool isUserNameTaken = std::any_of(m_connectedClients.begin(), m_connectedClients.end(), [&username](const auto& client)->bool {
-		return client->username == username;
+	const int64_t now = ServerTime();
+
+	if (m_gameInProgress)
+	{
+		// Once the results have been up for long enough the room closes so the queue can move on.
+		// The room's slots are only freed at the end of the tick, so the next room is seated next tick
+		if (m_raceOverAt >= 0 && now - m_raceOverAt >= network_clock::from_seconds(globals::matchmaking::k_resultsTime))
+		{
+			CloseRoom();
+		}
+		return;
+	}
+
+	// The players waiting for the room take the empty places in the order they arrived
+	while (m_cars.Size() < globals::game::k_playerAmount && m_matchmaker.Waiting() > 0)
+	{
+		const SessionHandle handle = m_matchmaker.Pop();
+		if (ClientSnapshot* player = m_sessions.Get(handle))
+		{
+			SeatPlayer(handle, *player);
+		}
+	}
+
+	// The room starts once it is full or its longest waiting player has waited long enough
+	int seated = 0;
+	int64_t longestWait = 0;
+	m_sessions.ForEach([&seated, &longestWait, now](const SessionHandle, const ClientSnapshot& player)
+		{
+			if (player.role == eSessionRole::e_Player)
+			{
+				++seated;
+				longestWait = std::max(longestWait, now - player.joinedAt);
+			}
 		});
 
-	return isUserNameTaken;
+	if (m_matchmaker.ShouldStartRoom(seated, longestWait))
+	{
+		StartRace();
+	}
 }
 
-void Server::CheckIfClientHasPassedCheckPoint(ClientSnapshot& client)
+void Server::StartRace()
 {
-	// Work out the bounding box of the client
-	sf::RectangleShape clientRect({ globals::cars::k_carSpriteWidth, globals::cars::k_carSpriteHeight });
-	clientRect.setOrigin(globals::cars::k_carOriginX, globals::cars::k_carOriginY);
+	// The AI takes the places nobody came for
+	int bots = 0;
+	while (m_cars.Size() < globals::game::k_playerAmount && AddBot())
+	{
+		++bots;
+	}
 
-	clientRect.setPosition(client.position);
+	m_gameInProgress = true;
+	m_raceOverAt = -1;
 
-	// See if the player has overlapped the checkpoints
-	for (int i = 0; i < globals::game::k_numCheckPoints; ++i)
-	{
-		if (LEVEL_CHECKPOINTS[i].intersects(clientRect.getGlobalBounds()))
+	const int64_t now = ServerTime();
+	m_sessions.ForEach([this, now](const SessionHandle, const ClientSnapshot& player)
 		{
-			if (i == 0)
-			{
-				if (client.lapsCompleted == 0 && client.checkPointsPassed[globals::game::k_numCheckPoints - 1])
-				{
-					client.checkPointsPassed[0] = true;
-				} else if (client.checkPointsPassed[globals::game::k_numCheckPoints - 1])
-				{
-					client.checkPointsPassed[0] = true;
-				}
-			} else
+			if (player.role == eSessionRole::e_Player)
 			{
-				client.checkPointsPassed[i] = true;
+				m_matchmaker.RecordTimeToRace(now - player.joinedAt);
 			}
+		});
 
-			// See if all the checkpoints have been passed
-			if (client.AllCheckPointsPassed() && client.lapsCompleted != globals::game::k_totalLaps)
-			{
-				std::cout << client.username << " has completed a lap!" << std::endl;
+	LOG_INFO("Starting the race with {} players and {} AI drivers", m_cars.Size() - bots, bots);
+	LOG_INFO("Time to race over the last {} players: p50 {}s, p90 {}s, p99 {}s", m_matchmaker.TimeToRaceSamples(),
+		m_matchmaker.TimeToRacePercentile(0.5f), m_matchmaker.TimeToRacePercentile(0.9f), m_matchmaker.TimeToRacePercentile(0.99f));
 
-				// Tell the client that they have completed a lap
-				if(!SendMessage({ eDataPacketType::e_LapCompleted, globals::k_reservedServerUsername }, client.username))
-				{
-					std::cout << "Failed to tell: " << client.username << " that they completed a lap..." << std::endl;
-				}
+	if(!BroadcastMessage({ eDataPacketType::e_StartGame, globals::k_reservedServerUsername }))
+	{
+		LOG_WARNING("Failed to tell all players the game is starting");
+	}
+}
 
-				client.lapsCompleted++;
-				client.ResetCheckPoints();
+void Server::CloseRoom()
+{
+	LOG_INFO("Closing the room, {} players are waiting for the next one", m_matchmaker.Waiting());
 
-				if (client.lapsCompleted == globals::game::k_totalLaps)
-				{
-					std::cout << client.username << " completed the race!" << std::endl;
-					client.raceCompleted = true;
+	// Everybody still in the room goes, bots and all. Taking the cars from the back means no car
+	// is moved into another's place
+	for (int car = m_cars.Size() - 1; car >= 0; --car)
+	{
+		const ClientSnapshot* racer = m_carOwners[car];
+		const SessionHandle handle = m_sessions.Find([racer](const ClientSnapshot& session)
+			{
+				return &session == racer;
+			});
 
-					// Tell the client that they completed the race
-					if(!SendMessage({ eDataPacketType::e_RaceCompleted, globals::k_reservedServerUsername }, client.username))
-					{
-						std::cout << "Failed to tell: " << client.username << " that they completed the race..." << std::endl;
-					}
-				}
-			}
+		// The spectators stay for the next room, whose cars reuse the network IDs
+		TcpDataPacket disconnectionData{ eDataPacketType::e_ClientDisconnected, racer->username };
+		disconnectionData.m_networkId = racer->networkId;
+
+		if (!BroadcastMessage(disconnectionData))
+		{
+			LOG_WARNING("Failed to tell all clients that {} left the room", racer->username);
 		}
+
+		RemoveCar(car);
+		RemoveSession(handle);
 	}
+
+	m_gameInProgress = false;
+	m_raceOverAt = -1;
+	m_physicsAccumulator = 0.f;
 }
 
-bool Server::SendMessage(const TcpDataPacket& dataToSend, const std::string& receiver)
+void Server::AddSpectator(const SessionHandle spectator)
 {
-	sf::Packet outPacket;
-	outPacket << dataToSend;
+	ClientSnapshot& session = *m_sessions.Get(spectator);
+
+	if (m_sessions.Count(eSessionRole::e_Spectator) >= globals::spectators::k_maxServerSpectators)
+	{
+		LOG_INFO("Maximum amount of spectators connected, rejecting {}", session.username);
 
-	m_connectedClients[FindClientIndex(receiver)]->socket->send(outPacket);
+		sf::Packet maxSpectatorsPkt;
+		const TcpDataPacket maxSpectatorsMessage(eDataPacketType::e_MaxPlayers, globals::k_reservedServerUsername);
+		maxSpectatorsPkt << maxSpectatorsMessage;
 
-	return true;
+		SendPacket(session, maxSpectatorsPkt);
+		RemoveSession(spectator);
+		return;
+	}
+
+	LOG_INFO("{} is spectating", session.username);
+
+	// Start them off with the whole race, after this they get the same messages as everybody else
+	sf::Packet keyframePkt;
+	keyframePkt << MakeKeyframe();
+
+	if (!SendPacket(session, keyframePkt))
+	{
+		LOG_WARNING("Failed to send the first keyframe to {}", session.username);
+		RemoveSession(spectator);
+		return;
+	}
+
+	session.role = eSessionRole::e_Spectator;
+	StartHeartbeats(spectator, session);
 }
 
-void Server::Update(const float deltaTime)
+void Server::ReceiveFromSpectator(const SessionHandle handle, ClientSnapshot& spectator)
 {
-	if (m_socketSelector.wait())
+	// Spectators never send input, anything they do send is thrown away
+	sf::Packet inPacket;
+	const auto spectatorStatus = spectator.socket->receive(inPacket);
+
+	if (spectatorStatus == sf::Socket::Done)
 	{
-		CheckForNewClients();
+		const int64_t receivedAt = ServerTime();
+		CountMessage(handle, spectator);
 
-		if (m_connectedClients.size() == globals::game::k_playerAmount)
+		// Apart from the answers to heartbeats, which time the connection
+		TcpDataPacket inData;
+		inPacket >> inData;
+		if (inData.m_type == eDataPacketType::e_Heartbeat)
 		{
-			if (!m_gameInProgress)
-			{
-				m_gameInProgress = true;
-				std::cout << globals::game::k_playerAmount << " have connected, starting the game..." << std::endl;
-				if(!BroadcastMessage({ eDataPacketType::e_StartGame, globals::k_reservedServerUsername }))
-				{
-					std::cout << "Failed to tell all players the game is starting!" << std::endl;
-				}
-			}
+			AddRttSample(spectator, inData, receivedAt);
 		}
+	} else if (spectatorStatus == sf::Socket::Disconnected)
+	{
+		LOG_INFO("{} disconnected from the server while watching or waiting", spectator.username);
+		RemoveSession(handle);
+	}
+}
 
-		// Loop through each client and use our new, fancy, socket selector
-		for (auto& client : m_connectedClients)
+TcpDataPacket Server::MakeKeyframe() const
+{
+	TcpDataPacket keyframe(eDataPacketType::e_WorldSnapshot, globals::k_reservedServerUsername);
+	WorldSnapshot& world = keyframe.m_worldSnapshot;
+
+	world.gameStarted = m_gameInProgress;
+	world.gameOver = m_gameInProgress && m_cars.Size() > 0 && CheckGameOver();
+
+	world.cars.resize(m_cars.Size());
+	for (int car = 0; car < m_cars.Size(); ++car)
+	{
+		const ClientSnapshot& owner = *m_carOwners[car];
+
+		WorldCar& worldCar = world.cars[car];
+		worldCar.networkId = owner.networkId;
+		worldCar.username = owner.username;
+		worldCar.x = m_cars.x[car];
+		worldCar.y = m_cars.y[car];
+		worldCar.angle = m_cars.angle[car];
+		worldCar.red = owner.colour.r;
+		worldCar.green = owner.colour.g;
+		worldCar.blue = owner.colour.b;
+		worldCar.lapsCompleted = static_cast<uint8_t>(m_cars.lapsCompleted[car]);
+	}
+
+	if (world.gameOver)
+	{
+		for (const int car : m_ranking.Order())
 		{
-			if (client && client->socket && m_socketSelector.isReady(*client->socket))
-			{
-				sf::Packet inPacket;
-				const auto clientStatus = client->socket->receive(inPacket);
+			world.placementOrder.emplace_back(m_carOwners[car]->username);
+		}
+	}
 
-				if (clientStatus == sf::Socket::Done)
-				{
-					TcpDataPacket inData;
+	return keyframe;
+}
 
-					inPacket >> inData;
+void Server::ResumeSession(const SessionHandle newClient, const TcpDataPacket& inData)
+{
+	ClientSnapshot& connection = *m_sessions.Get(newClient);
 
-					switch (inData.m_type)
-					{
-					case eDataPacketType::e_UpdatePosition:
-
-						client->position = { inData.m_x, inData.m_y };
-						client->angle = inData.m_angle;
-
-						if(BroadcastMessage(inData))
-						{
-							std::cout << "Error broadcasting messages to all clients" << std::endl;
-						}
-						
-						CheckIfClientHasPassedCheckPoint(*client);
-						
-						WorkOutTrackPlacements();
-
-						if (CheckGameOver())
-						{
-							// record the final race order
-							std::vector<std::string> racePositions;
-							for (const auto& racer : m_connectedClients)
-							{
-								std::cout << racer->username << std::endl;
-								racePositions.emplace_back(racer->username);
-							}
-
-							if(!BroadcastMessage({ eDataPacketType::e_GameOver, globals::k_reservedServerUsername, racePositions }))
-							{
-								std::cout << "Failed to tell the players that the race has ended!" << std::endl;
-							}
-						}
-						break;
-					default:
-						break;
-					}
-				}
+	// Tokens are never 0, so a client without one can't match anybody
+	const SessionHandle parked = m_sessions.Find([&inData](const ClientSnapshot& session)->bool {
+		return session.role == eSessionRole::e_Parked && session.resumeToken == inData.m_resumeToken && session.username == inData.m_userName;
+		});
+	ClientSnapshot* session = m_sessions.Get(parked);
 
-				if (clientStatus == sf::Socket::Disconnected)
-				{
-					std::string disconnectedClientUsername = client->username;
+	if (!session)
+	{
+		LOG_INFO("{} tried to resume a session that doesn't exist or has expired", inData.m_userName);
 
-					std::cout << "PLAYER WITH THE USERNAME: " << disconnectedClientUsername << " DISCONNECTED FROM THE SERVER" << std::endl;
+		sf::Packet rejectionPkt;
+		rejectionPkt << TcpDataPacket(eDataPacketType::e_ResumeRejected, globals::k_reservedServerUsername);
 
-					m_socketSelector.remove(*client->socket);
+		SendPacket(connection, rejectionPkt);
+		RemoveSession(newClient);
+		return;
+	}
 
-					client->socket->disconnect();
+	// The session takes over the new connection, which is already in the selector, and the dead
+	// socket is left in the new slot to be reused once it is freed
+	std::swap(session->socket, connection.socket);
+	RemoveSession(newClient);
 
-					// Remove from the vector
-					const int clientIndex = FindClientIndex(client->username);
+	// A token only works once, but the old one is only replaced once the client has been sent the
+	// new one, or a client whose reply is lost could never come back
+	const uint64_t newToken = MakeResumeToken();
 
-					m_connectedClients.erase(m_connectedClients.begin() + clientIndex);
+	// Everything the client missed fits in the one reply: the whole race, their place in it and
+	// the token for next time
+	TcpDataPacket resumedData = MakeKeyframe();
+	resumedData.m_type = eDataPacketType::e_SessionResumed;
+	resumedData.m_networkId = session->networkId;
+	resumedData.m_positionInRace = m_ranking.Rank(session->car) + 1;
+	resumedData.m_resumeToken = newToken;
 
-					// See if it was the last person to leave
-					if (m_connectedClients.empty())
-					{
-						m_gameInProgress = false;
-					}
+	sf::Packet resumedPkt;
+	resumedPkt << resumedData;
 
-					// Tell the other clients that a client disconnected
-					if(!BroadcastMessage({ eDataPacketType::e_ClientDisconnected, disconnectedClientUsername }))
-					{
-						std::cout << "Failed to tell all clients that another client disconnected" << std::endl;
-					}
-					return;
-				}
-			}
+	if (!SendPacket(*session, resumedPkt))
+	{
+		// Keep waiting for them, their resume timer is still running
+		LOG_WARNING("Failed to send the race to {}, their session stays parked", session->username);
+		m_socketSelector.remove(*session->socket);
+		session->socket->disconnect();
+		session->unsent.clear();
+		return;
+	}
 
-			if (client->raceCompleted)
-			{
-				AIMovement(deltaTime, *client);
-			}
-		}
+	LOG_INFO("{} resumed their session", session->username);
 
-		// Check collisions and update the clients accordingly...
-		CheckCollisionsBetweenClients();
+	session->resumeToken = newToken;
+	m_timers.Cancel(session->timers[static_cast<size_t>(eSessionTimer::e_ResumeExpiry)]);
+	session->role = eSessionRole::e_Player;
+	StartHeartbeats(parked, *session);
+}
+
+void Server::ExpireParkedSession(const SessionHandle handle, ClientSnapshot& session)
+{
+	LOG_INFO("{} didn't come back in time, removing them from the race", session.username);
+
+	RemoveCar(session.car);
+	RemoveSession(handle);
+
+	TcpDataPacket disconnectionData{ eDataPacketType::e_ClientDisconnected, session.username };
+	disconnectionData.m_networkId = session.networkId;
+
+	if(!BroadcastMessage(disconnectionData))
+	{
+		LOG_WARNING("Failed to tell all clients that {} disconnected", session.username);
+	}
+
+	if (!HasRacers())
+	{
+		CloseRoom();
+	} else if (m_gameInProgress && CheckGameOver())
+	{
+		// The race may only have been waiting for the player who didn't come back
+		FinishRace();
 	}
 }
 
-bool Server::BroadcastMessage(const TcpDataPacket& dataToSend) const
+void Server::RemoveSession(const SessionHandle handle)
 {
-	sf::Packet sendPacket;
-	sendPacket << dataToSend;
+	ClientSnapshot* session = m_sessions.Get(handle);
+	if (!session)
+	{
+		return;
+	}
 
-	// update the other connected clients
-	for (const auto& client : m_connectedClients)
+	if (session->role == eSessionRole::e_Queued)
 	{
-		// Make sure not to send the client their own data!
-		//if (client->m_username != dataToSend.m_userName && !client->m_raceCompleted)
-		{
-			if (client->socket->send(sendPacket) != sf::Socket::Done)
-			{
-				std::cout << "Error sending message to " << client->username << std::endl;
-				return false;
-			}
-		}
+		m_matchmaker.Remove(handle);
 	}
-	return true;
+
+	CancelTimers(*session);
+	m_socketSelector.remove(*session->socket);
+	m_sessions.Remove(handle);
+}
+
+void Server::StartTimer(const SessionHandle handle, ClientSnapshot& session, const eSessionTimer type, const float delay)
+{
+	TimerHandle& timer = session.timers[static_cast<size_t>(type)];
+	m_timers.Cancel(timer);
+	timer = m_timers.Schedule(delay, { handle, type });
+}
+
+void Server::CancelTimers(ClientSnapshot& session)
+{
+	for (auto& timer : session.timers)
+	{
+		m_timers.Cancel(timer);
+	}
+}
+
+void Server::StartHeartbeats(const SessionHandle handle, ClientSnapshot& session)
+{
+	StartTimer(handle, session, eSessionTimer::e_HeartbeatSend, globals::sessions::k_heartbeatInterval);
+	StartTimer(handle, session, eSessionTimer::e_HeartbeatTimeout, globals::sessions::k_heartbeatTimeout);
+}
+
+bool Server::CountMessage(const SessionHandle handle, ClientSnapshot& session)
+{
+	// Anything from the client shows it is still there
+	StartTimer(handle, session, eSessionTimer::e_HeartbeatTimeout, globals::sessions::k_heartbeatTimeout);
+
+	// The window starts with the first message in it, so a quiet client has no timer running
+	if (session.messagesThisWindow == 0)
+	{
+		StartTimer(handle, session, eSessionTimer::e_RateLimitWindow, globals::sessions::k_rateLimitWindow);
+	}
+
+	++session.messagesThisWindow;
+	if (session.messagesThisWindow == globals::sessions::k_rateLimitMessages + 1)
+	{
+		LOG_WARNING("{} is sending too many messages, dropping them for the rest of the window", session.username);
+	}
+
+	return session.messagesThisWindow <= globals::sessions::k_rateLimitMessages;
+}
+
+int64_t Server::ServerTime() const
+{
+	return network_clock::now() - m_startTime;
+}
+
+uint32_t Server::CurrentTick() const
+{
+	return static_cast<uint32_t>(ServerTime() / TICK_LENGTH);
+}
+
+void Server::AddRttSample(ClientSnapshot& session, const TcpDataPacket& answer, const int64_t receivedAt)
+{
+	// The heartbeat's send time comes back as the originate time
+	session.rtt.AddSample(network_clock::round_trip(answer.m_originateTime, answer.m_receiveTime, answer.m_transmitTime, receivedAt));
+}
+
+void Server::AnswerClockRequest(ClientSnapshot& session, const TcpDataPacket& request, const int64_t receivedAt) const
+{
+	TcpDataPacket response(eDataPacketType::e_ClockResponse, globals::k_reservedServerUsername);
+	response.m_originateTime = request.m_originateTime;
+	response.m_receiveTime = receivedAt;
+	response.m_serverTick = CurrentTick();
+	response.m_transmitTime = ServerTime();
+
+	sf::Packet responsePkt;
+	responsePkt << response;
+
+	if (!SendPacket(session, responsePkt))
+	{
+		LOG_WARNING("Failed to tell {} the time", session.username);
+	}
+}
+
+void Server::LogSessionStats() const
+{
+	m_sessions.ForEach([](const SessionHandle, const ClientSnapshot& session)
+		{
+			if (session.rtt.HasSamples())
+			{
+				LOG_INFO("{} RTT {}ms, jitter {}ms, best {}ms", session.username,
+					session.rtt.SmoothedRtt(), session.rtt.Jitter(), session.rtt.MinimumRtt());
+			}
+		});
+}
+
+void Server::OnTimer(const SessionTimer& timer)
+{
+	// The session may have gone since the timer was set
+	ClientSnapshot* session = m_sessions.Get(timer.session);
+	if (!session)
+	{
+		return;
+	}
+
+	session->timers[static_cast<size_t>(timer.type)] = {};
+
+	switch (timer.type)
+	{
+	case eSessionTimer::e_Handshake:
+		LOG_INFO("A client didn't introduce itself in time, closing the connection");
+		RemoveSession(timer.session);
+		break;
+
+	case eSessionTimer::e_HeartbeatSend:
+	{
+		// The client sends the time back with how long it held on to the heartbeat
+		TcpDataPacket heartbeat(eDataPacketType::e_Heartbeat, globals::k_reservedServerUsername);
+		heartbeat.m_transmitTime = ServerTime();
+
+		sf::Packet heartbeatPkt;
+		heartbeatPkt << heartbeat;
+
+		if (!SendPacket(*session, heartbeatPkt))
+		{
+			LOG_WARNING("Failed to send a heartbeat to {}", session->username);
+		}
+
+		StartTimer(timer.session, *session, eSessionTimer::e_HeartbeatSend, globals::sessions::k_heartbeatInterval);
+		break;
+	}
+
+	case eSessionTimer::e_HeartbeatTimeout:
+		LOG_INFO("{} stopped answering heartbeats", session->username);
+
+		if (session->role == eSessionRole::e_Player)
+		{
+			DropPlayer(timer.session, *session);
+		} else
+		{
+			RemoveSession(timer.session);
+		}
+		break;
+
+	case eSessionTimer::e_ResumeExpiry:
+		ExpireParkedSession(timer.session, *session);
+		break;
+
+	case eSessionTimer::e_RateLimitWindow:
+		session->messagesThisWindow = 0;
+		break;
+
+	default:
+		break;
+	}
+}
+
+uint64_t Server::MakeResumeToken()
+{
+	uint64_t token = 0;
+	while (token == 0)
+	{
+		// Straight from the system's source of randomness, so one token says nothing about the next
+		token = static_cast<uint64_t>(m_tokenSource()) << 32 | static_cast<uint64_t>(m_tokenSource());
+	}
+	return token;
+}
+
+bool Server::CheckGameOver() const
+{
+	// See if every racer has won
+	bool gameOver = true;
+	for (int car = 0; car < m_cars.Size(); ++car)
+	{
+		if (!m_cars.raceCompleted[car])
+		{
+			gameOver = false;
+		}
+	}
+
+	return gameOver;
+}
+
+void Server::FinishRace()
+{
+	// The race only ends once, however many of the last messages see that it is over
+	if (m_raceOverAt >= 0)
+	{
+		return;
+	}
+	m_raceOverAt = ServerTime();
+
+	// record the final race order
+	std::vector<std::string> racePositions;
+	for (const int car : m_ranking.Order())
+	{
+		LOG_INFO("Final placement: {}", m_carOwners[car]->username);
+		racePositions.emplace_back(m_carOwners[car]->username);
+	}
+
+	LOG_INFO("Final world state hash: {}", m_cars.Hash());
+
+	if(!BroadcastMessage({ eDataPacketType::e_GameOver, globals::k_reservedServerUsername, racePositions }))
+	{
+		LOG_WARNING("Failed to tell the players that the race has ended");
+	}
+}
+
+void Server::CheckCollisionsBetweenClients()
+{
+	// Broad phase: sort the cars into the grid and only consider cars in neighbouring cells
+	m_collisionGrid.Build(m_cars.Size(), [this](const int car)
+		{
+			return m_cars.Position(car);
+		});
+
+	m_collisionGrid.FindPairs(m_collisionPairs);
+
+	// Narrow phase: resolve each candidate pair, keeping the pairs that collided at the front
+	// of the vector so that the messages can be sent once all of the resolution is done
+	size_t collidedPairs = 0;
+	for (const auto& [a, b] : m_collisionPairs)
+	{
+		// Two players' cars were judged as each update arrived, against where the other was then
+		if (!m_cars.aiDriven[a] && !m_cars.aiDriven[b])
+		{
+			continue;
+		}
+
+		if (ResolveCollision(a, b, m_cars.Position(b), m_cars.angle[b]))
+		{
+			m_collisionPairs[collidedPairs++] = { a, b };
+		}
+	}
+
+	// Update the clients on the resolved collisions
+	for (size_t i = 0; i < collidedPairs; ++i)
+	{
+		const auto [car, otherCar] = m_collisionPairs[i];
+		RecordHistory(car);
+		RecordHistory(otherCar);
+		SendCollision(car, otherCar);
+	}
+}
+
+void Server::CompensateCollisions(const int car, const int64_t viewTime)
+{
+	// There are only a handful of cars, so every other car is tested without a broad phase
+	for (int otherCar = 0; otherCar < m_cars.Size(); ++otherCar)
+	{
+		if (otherCar == car)
+		{
+			continue;
+		}
+
+		sf::Vector2f otherPosition;
+		float otherAngle;
+		m_history.StateAt(otherCar, viewTime, otherPosition, otherAngle);
+
+		if (ResolveCollision(car, otherCar, otherPosition, otherAngle))
+		{
+			RecordHistory(car);
+			RecordHistory(otherCar);
+			SendCollision(car, otherCar);
+		}
+	}
+}
+
+void Server::RecordHistory(const int car)
+{
+	m_history.Record(car, ServerTime(), m_cars.Position(car), m_cars.angle[car]);
+}
+
+int64_t Server::EstimateViewTime(const ClientSnapshot& client, const TcpDataPacket& update, const int64_t receivedAt) const
+{
+	int64_t viewTime = update.m_serverTick != 0 ?
+		static_cast<int64_t>(update.m_serverTick) * TICK_LENGTH :
+		receivedAt - network_clock::from_seconds(client.rtt.SmoothedRtt() / 1000.f);
+
+	// A client can't claim to be seeing the future, or reach back further than the rewind window
+	const int64_t earliest = receivedAt - network_clock::from_seconds(globals::lag_compensation::k_maxRewind);
+	return std::clamp(viewTime, earliest, receivedAt);
+}
+
+void Server::SendCollision(const int car, const int otherCar)
+{
+	const ClientSnapshot& client = *m_carOwners[car];
+	const ClientSnapshot& otherClient = *m_carOwners[otherCar];
+
+	TcpDataPacket collisionData{ eDataPacketType::e_CollisionData, client.username, m_cars.Position(car), otherClient.username };
+	collisionData.m_networkId = client.networkId;
+
+	if(!SendMessage(collisionData, client.username))
+	{
+		LOG_WARNING("Failed to send collision data to {}", client.username);
+	}
+
+	TcpDataPacket otherCollisionData{ eDataPacketType::e_CollisionData, otherClient.username, m_cars.Position(otherCar), client.username };
+	otherCollisionData.m_networkId = otherClient.networkId;
+
+	if(!SendMessage(otherCollisionData, otherClient.username))
+	{
+		LOG_WARNING("Failed to send collision data to {}", otherClient.username);
+	}
+}
+
+bool Server::ResolveCollision(const int car, const int otherCar, const sf::Vector2f& otherPosition, const float otherAngle)
+{
+	sf::Vector2f minimumTranslation;
+
+	if (!collision::separating_axis_test(
+		collision::make_car_box(m_cars.Position(car), m_cars.angle[car]),
+		collision::make_car_box(otherPosition, otherAngle),
+		minimumTranslation))
+	{
+		return false;
+	}
+
+	// Push both cars half of the way out along the minimum translation vector
+	// so the collision is resolved in a single step
+	m_cars.x[car] += minimumTranslation.x / 2.f;
+	m_cars.y[car] += minimumTranslation.y / 2.f;
+	m_cars.x[otherCar] -= minimumTranslation.x / 2.f;
+	m_cars.y[otherCar] -= minimumTranslation.y / 2.f;
+
+	return true;
+}
+
+void Server::WorkOutTrackPlacements()
+{
+	m_ranking.FlushChanges([this](const int car, const int rank)
+		{
+			const std::string& username = m_carOwners[car]->username;
+
+			LOG_DEBUG("\tPosition {} : {}", rank + 1, username);
+			if(!SendMessage({ eDataPacketType::e_Overtaken, globals::k_reservedServerUsername, rank + 1 }, username))
+			{
+				LOG_WARNING("Failed to send a message to {}", username);
+			}
+		});
+}
+
+void Server::AIMovement(const float deltaTime)
+{
+	// The physics always moves in fixed steps, so run as many as the time since the last tick covers
+	m_physicsAccumulator = std::min(m_physicsAccumulator + deltaTime, car_physics::k_maxCatchUp);
+
+	// Where the cars start the steps, so the bots' checkpoints can be checked over the whole move
+	for (int car = 0; car < m_cars.Size(); ++car)
+	{
+		m_stepStartPositions[car] = m_cars.Position(car);
+	}
+
+	bool stepped = false;
+	while (m_physicsAccumulator >= car_physics::k_fixedStep)
+	{
+		m_physicsAccumulator -= car_physics::k_fixedStep;
+		stepped = true;
+
+		// The AI slows down on the grass, the same as the players do
+		m_track.Surface().Lookup(m_cars.x.data(), m_cars.y.data(), m_cars.Size(), m_carSurfaces.data());
+		for (int car = 0; car < m_cars.Size(); ++car)
+		{
+			m_cars.speed[car] = SurfaceMask::SpeedOn(m_carSurfaces[car]);
+		}
+
+		m_aiDrivers.Update(m_cars, m_track);
+	}
+
+	if (!stepped)
+	{
+		return;
+	}
+
+	// Update the clients on the AI moves once all the steps are done
+	for (const int car : m_aiDrivers.MovedCars())
+	{
+		const ClientSnapshot& owner = *m_carOwners[car];
+		RecordHistory(car);
+
+		// The bots race like everyone else until they finish, the server is their client
+		if (!m_cars.raceCompleted[car])
+		{
+			CheckIfClientHasPassedCheckPoint(car, m_stepStartPositions[car], ServerTime());
+			UpdateRaceProgress(car);
+			m_ranking.Update(car, m_cars.progress.data());
+		}
+
+		TcpDataPacket positionData{ eDataPacketType::e_UpdatePosition, owner.username, m_cars.x[car], m_cars.y[car], m_cars.angle[car] };
+		positionData.m_networkId = owner.networkId;
+		positionData.m_serverTick = CurrentTick();
+
+		if(!BroadcastMessage(positionData))
+		{
+			LOG_WARNING("Failed to broadcast the AI movement of {}", owner.username);
+		}
+	}
+
+	// A bot may have been the last to finish
+	if (CheckGameOver())
+	{
+		FinishRace();
+	}
+}
+
+ClientSnapshot* Server::FindRacer(const std::string& username)
+{
+	return m_sessions.Get(m_sessions.Find([&username](const ClientSnapshot& client)->bool {
+		return is_racer(client.role) && client.username == username;
+		}));
+}
+
+bool Server::IsUsernameTaken(const std::string& username) const
+{
+	// A parked session keeps its username for when its client comes back, and a queued player
+	// keeps theirs for the next room
+	const bool isUserNameTaken = m_sessions.Find([&username](const ClientSnapshot& client)->bool {
+		return (is_racer(client.role) || client.role == eSessionRole::e_Queued) && client.username == username;
+		}).IsValid();
+
+	return isUserNameTaken;
+}
+
+uint16_t Server::FindFreeNetworkId() const
+{
+	uint16_t networkId = 0;
+	while (m_sessions.Find([networkId](const ClientSnapshot& client)->bool {
+		return is_racer(client.role) && client.networkId == networkId;
+		}).IsValid())
+	{
+		++networkId;
+	}
+
+	return networkId;
+}
+
+int Server::FindFreeGridSlot() const
+{
+	int gridSlot = 0;
+	while (m_sessions.Find([gridSlot](const ClientSnapshot& client)->bool {
+		return is_racer(client.role) && client.gridSlot == gridSlot;
+		}).IsValid())
+	{
+		++gridSlot;
+	}
+
+	return gridSlot;
+}
+
+void Server::CheckIfClientHasPassedCheckPoint(const int car, const sf::Vector2f& previousPosition, const int64_t viewTime)
+{
+	const sf::Vector2f position = m_cars.Position(car);
+
+	int32_t& nextCheckPoint = m_cars.nextCheckPoint[car];
+	int32_t& lapsCompleted = m_cars.lapsCompleted[car];
+	const std::string& username = m_carOwners[car]->username;
+
+	// A long update can cross more than one gate, so keep going until the next gate is missed
+	const int checkPointCount = m_track.CheckPointCount();
+	for (int crossed = 0; crossed < checkPointCount; ++crossed)
+	{
+		const track_format::CheckPoint& checkPoint = m_track.GetCheckPoint(nextCheckPoint);
+		if (!collision::segments_intersect(previousPosition, position, checkPoint.gateStart, checkPoint.gateEnd))
+		{
+			return;
+		}
+
+		if (nextCheckPoint != 0)
+		{
+			nextCheckPoint = (nextCheckPoint + 1) % checkPointCount;
+			continue;
+		}
+
+		// Crossing the finish line after every other checkpoint completes a lap
+		nextCheckPoint = 1;
+
+		LOG_INFO("{} has completed a lap", username);
+
+		// Tell the client that they have completed a lap
+		if(!SendMessage({ eDataPacketType::e_LapCompleted, globals::k_reservedServerUsername }, username))
+		{
+			LOG_WARNING("Failed to tell {} that they completed a lap", username);
+		}
+
+		lapsCompleted++;
+
+		if (lapsCompleted == globals::game::k_totalLaps)
+		{
+			LOG_INFO("{} completed the race", username);
+
+			// Freeze the progress past the end of the race, earlier finishers staying further ahead.
+			// Finishers are placed by when their drivers saw them cross, so one whose update was slower
+			// to arrive can still beat a car that was already counted, which drops a place
+			m_cars.finishTime[car] = viewTime;
+
+			int finishedBefore = 0;
+			for (int otherCar = 0; otherCar < m_cars.Size(); ++otherCar)
+			{
+				if (!m_cars.raceCompleted[otherCar])
+				{
+					continue;
+				}
+
+				if (m_cars.finishTime[otherCar] <= viewTime)
+				{
+					++finishedBefore;
+				} else
+				{
+					m_cars.progress[otherCar] -= 1.f;
+					m_ranking.Update(otherCar, m_cars.progress.data());
+				}
+			}
+			m_cars.progress[car] = globals::game::k_totalLaps * m_track.Centreline().Length() +
+				static_cast<float>(globals::game::k_playerAmount - finishedBefore);
+
+			// The AI drives the car from now on
+			m_cars.raceCompleted[car] = 1;
+			m_cars.aiDriven[car] = 1;
+
+			// Tell the client that they completed the race
+			if(!SendMessage({ eDataPacketType::e_RaceCompleted, globals::k_reservedServerUsername }, username))
+			{
+				LOG_WARNING("Failed to tell {} that they completed the race", username);
+			}
+			return;
+		}
+	}
+}
+
+void Server::UpdateRaceProgress(const int car)
+{
+	if (m_cars.raceCompleted[car])
+	{
+		return;
+	}
+
+	const float length = m_track.Centreline().Length();
+	float distance = m_track.Centreline().DistanceAlong(m_cars.Position(car), m_cars.centrelineSegment[car]);
+
+	// The centreline wraps at the finish line, so near it the distance can belong to the lap either
+	// side. The next checkpoint says which side of the finish line the car is really on
+	const int32_t nextCheckPoint = m_cars.nextCheckPoint[car];
+	if (nextCheckPoint == 1 && distance > length / 2.f)
+	{
+		distance -= length;
+	}
+	else if (nextCheckPoint == 0 && distance < length / 2.f)
+	{
+		distance += length;
+	}
+
+	m_cars.progress[car] = static_cast<float>(m_cars.lapsCompleted[car]) * length + distance;
+}
+
+bool Server::SendMessage(const TcpDataPacket& dataToSend, const std::string& receiver)
+{
+	sf::Packet outPacket;
+	outPacket << dataToSend;
+
+	ClientSnapshot* receiverSession = FindRacer(receiver);
+	if (!receiverSession)
+	{
+		return false;
+	}
+
+	// A parked session catches up from a keyframe when it resumes, so its messages are dropped, and
+	// a bot has nobody to send to
+	if (receiverSession->role == eSessionRole::e_Parked || receiverSession->role == eSessionRole::e_Bot)
+	{
+		return true;
+	}
+
+	return SendPacket(*receiverSession, outPacket);
+}
+
+void Server::Update(const float deltaTime)
+{
+	// Wake up for the tick even if nobody has sent anything
+	if (m_socketSelector.wait(sf::seconds(globals::game::k_serverTickTime)))
+	{
+		CheckForNewClients();
+
+		// Note every session with something to read before reading any, a session that changes role
+		// or takes over another's socket during the tick must only be read once
+		m_readySessions.clear();
+		m_sessions.ForEach([this](const SessionHandle handle, const ClientSnapshot& client)
+			{
+				if (m_socketSelector.isReady(*client.socket))
+				{
+					m_readySessions.push_back(handle);
+				}
+			});
+
+		// Loop through each client and use our new, fancy, socket selector
+		for (const SessionHandle handle : m_readySessions)
+		{
+			ClientSnapshot* client = m_sessions.Get(handle);
+			if (!client)
+			{
+				continue;
+			}
+
+			switch (client->role)
+			{
+			case eSessionRole::e_Pending:
+				ReceiveIntroduction(handle, *client);
+				break;
+			case eSessionRole::e_Player:
+				ReceiveFromPlayer(handle, *client);
+				break;
+			case eSessionRole::e_Spectator:
+			case eSessionRole::e_Queued:
+				ReceiveFromSpectator(handle, *client);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	// Seat the queue and start the room once it is ready, which can come from the wait running out
+	// as well as from a new player
+	Matchmake();
+
+	// Keep the spectators in step, in case they fell behind or missed something
+	m_keyframeTimer += deltaTime;
+	if (m_keyframeTimer >= globals::spectators::k_keyframeInterval)
+	{
+		m_keyframeTimer = 0.f;
+
+		if (m_sessions.Count(eSessionRole::e_Spectator) > 0)
+		{
+			sf::Packet keyframePkt;
+			keyframePkt << MakeKeyframe();
+
+			m_sessions.ForEach([&keyframePkt](const SessionHandle, ClientSnapshot& spectator)
+				{
+					if (spectator.role == eSessionRole::e_Spectator && !SendPacket(spectator, keyframePkt))
+					{
+						LOG_WARNING("Failed to send a keyframe to {}", spectator.username);
+					}
+				});
+		}
+	}
+
+	m_statsTimer += deltaTime;
+	if (m_statsTimer >= globals::sessions::k_statsInterval)
+	{
+		m_statsTimer = 0.f;
+		LogSessionStats();
+	}
+
+	// Fire the heartbeats, timeouts and expiries that have come due
+	m_timers.Advance(deltaTime, [this](const SessionTimer& timer) { OnTimer(timer); });
+
+	if (m_gameInProgress)
+	{
+		// Drive the cars of everybody who has finished
+		AIMovement(deltaTime);
+
+		// Check collisions and update the clients accordingly...
+		CheckCollisionsBetweenClients();
+
+		// Let everyone know about the overtakes that happened this tick
+		WorkOutTrackPlacements();
+	}
+
+	// Send what the sockets couldn't take earlier. A client that has gone is noticed when it is read
+	// from, and one that has stopped reading stops answering its heartbeats
+	m_sessions.ForEach([](const SessionHandle, ClientSnapshot& session)
+		{
+			FlushSession(session);
+		});
+
+	// The sessions removed during the tick are only freed now, so nothing above saw a slot reused
+	m_sessions.CollectRemoved();
+}
+
+void Server::ReceiveFromPlayer(const SessionHandle handle, ClientSnapshot& client)
+{
+	sf::Packet inPacket;
+	const auto clientStatus = client.socket->receive(inPacket);
+
+	if (clientStatus == sf::Socket::Done && CountMessage(handle, client))
+	{
+		const int64_t receivedAt = ServerTime();
+		TcpDataPacket inData;
+
+		inPacket >> inData;
+
+		switch (inData.m_type)
+		{
+		case eDataPacketType::e_UpdatePosition:
+		{
+			const sf::Vector2f previousPosition = m_cars.Position(client.car);
+			const int64_t viewTime = EstimateViewTime(client, inData, receivedAt);
+
+			m_cars.SetPosition(client.car, { inData.m_x, inData.m_y });
+			m_cars.angle[client.car] = inData.m_angle;
+			RecordHistory(client.car);
+
+			// Judge the move against the other cars where the player saw them, and pass on where the
+			// car ended up
+			CompensateCollisions(client.car, viewTime);
+			inData.m_x = m_cars.x[client.car];
+			inData.m_y = m_cars.y[client.car];
+
+			// The server decides who the message is about, not the client
+			inData.m_userName = client.username;
+			inData.m_networkId = client.networkId;
+			inData.m_serverTick = CurrentTick();
+
+			if(!BroadcastMessage(inData))
+			{
+				LOG_WARNING("Error broadcasting the position of {} to all clients", client.username);
+			}
+			
+			CheckIfClientHasPassedCheckPoint(client.car, previousPosition, viewTime);
+			UpdateRaceProgress(client.car);
+			m_ranking.Update(client.car, m_cars.progress.data());
+
+			if (CheckGameOver())
+			{
+				FinishRace();
+			}
+			break;
+		}
+		case eDataPacketType::e_Heartbeat:
+			AddRttSample(client, inData, receivedAt);
+			break;
+		case eDataPacketType::e_ClockRequest:
+			AnswerClockRequest(client, inData, receivedAt);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (clientStatus == sf::Socket::Disconnected)
+	{
+		LOG_INFO("The player with the username {} disconnected from the server", client.username);
+		DropPlayer(handle, client);
+	}
+}
+
+void Server::DropPlayer(const SessionHandle handle, ClientSnapshot& client)
+{
+	m_socketSelector.remove(*client.socket);
+
+	client.socket->disconnect();
+	client.unsent.clear();
+
+	// Mid race the session and car wait for the client to resume, the others aren't
+	// told unless the client doesn't make it back in time
+	if (m_gameInProgress && !CheckGameOver())
+	{
+		LOG_INFO("Keeping the session of {} for {} seconds", client.username, globals::sessions::k_resumeGracePeriod);
+
+		CancelTimers(client);
+		client.role = eSessionRole::e_Parked;
+		client.messagesThisWindow = 0;
+		StartTimer(handle, client, eSessionTimer::e_ResumeExpiry, globals::sessions::k_resumeGracePeriod);
+		return;
+	}
+
+	// Remove their car, the last car is moved into its place so its owner needs to know
+	RemoveCar(client.car);
+
+	// The slot is freed at the end of the tick
+	RemoveSession(handle);
+
+	// See if it was the last person to leave, the bots go with them
+	if (!HasRacers())
+	{
+		CloseRoom();
+	}
+
+	// Tell the other clients that a client disconnected
+	TcpDataPacket disconnectionData{ eDataPacketType::e_ClientDisconnected, client.username };
+	disconnectionData.m_networkId = client.networkId;
+
+	if(!BroadcastMessage(disconnectionData))
+	{
+		LOG_WARNING("Failed to tell all clients that {} disconnected", client.username);
+	}
+}
+
+void Server::RemoveCar(const int car)
+{
+	const int movedCar = m_cars.Remove(car);
+	m_ranking.Remove(car, movedCar);
+	m_history.Remove(car, movedCar);
+
+	if (movedCar != -1)
+	{
+		m_carOwners[car] = m_carOwners[movedCar];
+		m_carOwners[car]->car = car;
+	}
+
+	m_carOwners.pop_back();
+}
+
+bool Server::BroadcastMessage(const TcpDataPacket& dataToSend)
+{
+	sf::Packet sendPacket;
+	sendPacket << dataToSend;
+
+	// update the other connected clients, and the spectators watch the same messages
+	bool sentToPlayers = true;
+	m_sessions.ForEach([&sendPacket, &sentToPlayers](const SessionHandle, ClientSnapshot& client)
+		{
+			if (client.role == eSessionRole::e_Player)
+			{
+				if (!SendPacket(client, sendPacket))
+				{
+					LOG_WARNING("Error sending message to {}", client.username);
+					sentToPlayers = false;
+				}
+			} else if (client.role == eSessionRole::e_Spectator)
+			{
+				if (!SendPacket(client, sendPacket))
+				{
+					LOG_WARNING("Error sending message to the spectator {}", client.username);
+				}
+			}
+		});
+
+	return sentToPlayers;
+}
+
+bool Server::SendPacket(ClientSnapshot& session, const sf::Packet& packet)
+{
+	const size_t size = packet.getDataSize();
+	if (session.unsent.size() + sizeof(uint32_t) + size > MAX_UNSENT_BYTES)
+	{
+		return false;
+	}
+
+	// Framed the same way the socket frames a packet, its size as a big endian 32 bit number first
+	const auto length = static_cast<uint32_t>(size);
+	session.unsent.push_back(static_cast<char>((length >> 24) & 0xFF));
+	session.unsent.push_back(static_cast<char>((length >> 16) & 0xFF));
+	session.unsent.push_back(static_cast<char>((length >> 8) & 0xFF));
+	session.unsent.push_back(static_cast<char>(length & 0xFF));
+
+	const char* data = static_cast<const char*>(packet.getData());
+	session.unsent.insert(session.unsent.end(), data, data + size);
+
+	const sf::Socket::Status status = FlushSession(session);
+	return status != sf::Socket::Disconnected && status != sf::Socket::Error;
+}
+
+sf::Socket::Status Server::FlushSession(ClientSnapshot& session)
+{
+	if (session.unsent.empty())
+	{
+		return sf::Socket::Done;
+	}
+
+	std::size_t sent = 0;
+	const sf::Socket::Status status = session.socket->send(session.unsent.data(), session.unsent.size(), sent);
+	session.unsent.erase(session.unsent.begin(), session.unsent.begin() + static_cast<std::ptrdiff_t>(sent));
+
+	return status;
+}
+
+bool Server::HasRacers() const
+{
+	return m_sessions.Count(eSessionRole::e_Player) + m_sessions.Count(eSessionRole::e_Parked) > 0;
 }
@@ -1,9 +1,19 @@
 ﻿#pragma once
+#include <random>
 #include <SFML/Network.hpp>
 
 
-#include "ClientSnapshot.h"
+#include "AIDriverBatch.h"
+#include "CarHistory.h"
+#include "CarStateStore.h"
+#include "Matchmaker.h"
+#include "RaceRanking.h"
+#include "SessionTable.h"
+#include "SpatialGrid.h"
+#include "TimerWheel.h"
 #include "../Shared Files/Data.h"
+#include "../Shared Files/NetworkClock.h"
+#include "../Shared Files/TrackAsset.h"
 
 /**
  * \brief The Server of the racing game
@@ -35,6 +45,15 @@ public:
 	~Server() = default;
 
 private:
+	/**
+	 * \brief What a timer in m_timers is for
+	 */
+	struct SessionTimer
+	{
+		SessionHandle session;
+		eSessionTimer type = eSessionTimer::e_Handshake;
+	};
+
 	// The listener for the TCP sockets, to establish and maintain a connection
 	sf::TcpListener m_listener;
 
@@ -42,12 +61,80 @@ private:
 	// to the server
 	sf::SocketSelector m_socketSelector;
 
-	// A vector of all of the connected clients in the game
-	std::vector<std::unique_ptr<ClientSnapshot>> m_connectedClients;
+	// Every session: the connected players, the spectators, which are normally relays that pass the
+	// race on to the real audience, and the parked sessions of players whose connection dropped
+	// during the race. A parked player's car stays on the track until they resume the session with
+	// its token or globals::sessions::k_resumeGracePeriod runs out
+	SessionTable m_sessions;
+
+	// The sessions whose sockets had something to read this tick, kept so the memory is reused
+	std::vector<SessionHandle> m_readySessions;
+
+	// Every session's timers: handshake deadlines, heartbeats, parked sessions running out and
+	// rate limit windows
+	TimerWheel<SessionTimer> m_timers;
+
+	// The time since the spectators were last sent a keyframe
+	float m_keyframeTimer;
+
+	// When the server started on the steady clock, in microseconds. Every time the server sends is
+	// counted from here, so tick 0 starts when the server does
+	int64_t m_startTime;
+
+	// The time since the round trip times of the sessions were last logged
+	float m_statsTimer;
+
+	// Makes the resume tokens, which must not be guessable from the ones handed out before
+	std::random_device m_tokenSource;
+
+	// Decides when the room starts racing, and keeps the players waiting for the next room
+	Matchmaker m_matchmaker;
+
+	// When the race ended in server time, so the room can close once the results have been up
+	// for a while, -1 while there is no finished race
+	int64_t m_raceOverAt;
+
+	// The simulation state of every car in the race
+	CarStateStore m_cars;
+
+	// Where every car has been over the last moments, indexed the same as m_cars, so a player's move
+	// is judged against the other cars where that player saw them
+	CarHistory m_history;
+
+	// The client that owns each car, indexed the same as m_cars. The sessions never move in the
+	// table, and a car is always removed before its session
+	std::vector<ClientSnapshot*> m_carOwners;
+
+	// Drives the cars of the clients who have finished the race
+	AIDriverBatch m_aiDrivers;
+
+	// The cars in race order
+	RaceRanking m_ranking;
+
+	// The checkpoints, starting grid, centreline, racing line and surface of the track
+	TrackAsset m_track;
+
+	// The surface under each car, indexed the same as m_cars and kept between ticks so the
+	// memory is reused
+	std::vector<eSurfaceType> m_carSurfaces;
+
+	// Where each car was before the AI's latest steps, indexed the same as m_cars and kept between
+	// ticks so the memory is reused
+	std::vector<sf::Vector2f> m_stepStartPositions;
+
+	// The time that hasn't been simulated yet, less than one physics step once the AI has moved
+	float m_physicsAccumulator;
 
 	// A flag for whether the race has started or not
 	bool m_gameInProgress;
 
+	// The broad phase for collisions between the cars
+	SpatialGrid m_collisionGrid;
+
+	// The pairs of cars that are close enough to possibly be colliding, kept between ticks
+	// so the memory is reused
+	std::vector<std::pair<int, int>> m_collisionPairs;
+
 	Server();
 
 	/**
@@ -59,70 +146,363 @@ private:
 
 	/**
 	 * \brief Scans the socket selector in case a new client wants
-	 * to connect to the game. Handles rejection if the server is full
-	 * or if a race is already in progress
+	 * to connect to the game, and gives it until the handshake timeout
+	 * to introduce itself
 	 */
 	void CheckForNewClients();
+
+	/**
+	 * \brief Reads the first message of a new connection and lets the client in as a player or
+	 * spectator, or resumes its session. A player joins the room if it is still forming and
+	 * otherwise waits in the queue for the next one
+	 * \param handle The table handle of the new connection's session
+	 * \param newClient The new connection's session, as found with the handle
+	 */
+	void ReceiveIntroduction(SessionHandle handle, ClientSnapshot& newClient);
+
+	/**
+	 * \brief Gives a player or bot the next place on the grid and a car there
+	 * \param racer The session to give the place to
+	 * \return The starting position of the car
+	 */
+	sf::Vector2f PlaceOnGrid(ClientSnapshot& racer);
+
+	/**
+	 * \param racer A session with a car
+	 * \return The e_NewClient message that introduces the racer and their car to a client
+	 */
+	[[nodiscard]] TcpDataPacket MakeNewClientMessage(const ClientSnapshot& racer) const;
+
+	/**
+	 * \brief Lets a player into the room, confirming their username with their place on the grid
+	 * and introducing them to everybody
+	 * \param handle The table handle of the player's session
+	 * \param player The player's session, as found with the handle
+	 */
+	void SeatPlayer(SessionHandle handle, ClientSnapshot& player);
+
+	/**
+	 * \brief Puts a player in the queue for the next room and tells them their place, or turns them
+	 * away if the queue is full
+	 * \param handle The table handle of the player's session
+	 * \param player The player's session, as found with the handle
+	 */
+	void QueuePlayer(SessionHandle handle, ClientSnapshot& player);
+
+	/**
+	 * \brief Fills the next place on the grid with a car driven by the server's AI
+	 * \return False if there was no session slot left for the bot
+	 */
+	bool AddBot();
+
+	/**
+	 * \return A username for a bot that nobody is using
+	 */
+	[[nodiscard]] std::string MakeBotName() const;
+
+	/**
+	 * \brief Seats the players waiting for the room, starts the race once the matchmaker says the
+	 * room is ready and closes the room once the results have been up long enough
+	 */
+	void Matchmake();
+
+	/**
+	 * \brief Fills the empty places with bots, notes everybody's time to race and starts the race
+	 */
+	void StartRace();
+
+	/**
+	 * \brief Ends the room: the bots and any players still there are removed and the next room
+	 * can form
+	 */
+	void CloseRoom();
+
+	/**
+	 * \brief Accepts a spectator if there is room and starts them off with a keyframe
+	 * \param spectator The new session, which is removed if it is rejected
+	 */
+	void AddSpectator(SessionHandle spectator);
+
+	/**
+	 * \brief Reads a message from a player and acts on it, parking or removing the session if
+	 * the player disconnected
+	 * \param handle The table handle of the player's session
+	 * \param client The player's session, as found with the handle
+	 */
+	void ReceiveFromPlayer(SessionHandle handle, ClientSnapshot& client);
+
+	/**
+	 * \brief Reads from a spectator or a player waiting in the queue so their disconnection is
+	 * noticed, throwing away anything they send apart from the answers to heartbeats
+	 * \param handle The table handle of the spectator's session
+	 * \param spectator The spectator's session, as found with the handle
+	 */
+	void ReceiveFromSpectator(SessionHandle handle, ClientSnapshot& spectator);
+
+	/**
+	 * \brief Deals with a player whose connection has gone. Mid race the session is parked for
+	 * them to resume, otherwise they are removed from the game
+	 * \param handle The table handle of the player's session
+	 * \param client The player's session, as found with the handle
+	 */
+	void DropPlayer(SessionHandle handle, ClientSnapshot& client);
+
+	/**
+	 * \brief Cancels a session's timers, takes its socket out of the selector and removes it
+	 * \param handle The session to remove
+	 */
+	void RemoveSession(SessionHandle handle);
+
+	/**
+	 * \brief Sets one of a session's timers going, replacing the timer of the same type if it has one
+	 * \param handle The table handle of the session
+	 * \param session The session, as found with the handle
+	 * \param type Which of the session's timers to set
+	 * \param delay The time until it fires in seconds
+	 */
+	void StartTimer(SessionHandle handle, ClientSnapshot& session, eSessionTimer type, float delay);
+
+	/**
+	 * \param session The session whose timers to cancel
+	 */
+	void CancelTimers(ClientSnapshot& session);
+
+	/**
+	 * \brief Starts sending heartbeats to a session that has been let in, and expecting answers
+	 * \param handle The table handle of the session
+	 * \param session The session, as found with the handle
+	 */
+	void StartHeartbeats(SessionHandle handle, ClientSnapshot& session);
+
+	/**
+	 * \brief Notes a message from a session: it is alive, and it counts towards the rate limit
+	 * \param handle The table handle of the session
+	 * \param session The session, as found with the handle
+	 * \return False if the session has sent too many messages this window and the message should
+	 * be dropped
+	 */
+	bool CountMessage(SessionHandle handle, ClientSnapshot& session);
+
+	/**
+	 * \return The time since the server started in microseconds, what the server stamps its
+	 * messages with
+	 */
+	[[nodiscard]] int64_t ServerTime() const;
+
+	/**
+	 * \return The fixed physics step the server is on, counted from when it started
+	 */
+	[[nodiscard]] uint32_t CurrentTick() const;
+
+	/**
+	 * \brief Takes a round trip time sample from the answer to a heartbeat
+	 * \param session The session that answered
+	 * \param answer The e_Heartbeat the session sent back
+	 * \param receivedAt When the answer arrived, from ServerTime
+	 */
+	static void AddRttSample(ClientSnapshot& session, const TcpDataPacket& answer, int64_t receivedAt);
+
+	/**
+	 * \brief Answers a client asking the time, so it can work out how far its clock is from the server's
+	 * \param session The session that asked
+	 * \param request The e_ClockRequest the session sent
+	 * \param receivedAt When the request arrived, from ServerTime
+	 */
+	void AnswerClockRequest(ClientSnapshot& session, const TcpDataPacket& request, int64_t receivedAt) const;
+
+	/**
+	 * \brief Logs the round trip time and jitter of every session that has answered a heartbeat
+	 */
+	void LogSessionStats() const;
+
+	/**
+	 * \brief Acts on a timer that has fired
+	 * \param timer The timer
+	 */
+	void OnTimer(const SessionTimer& timer);
+
+	/**
+	 * \return A keyframe of every car and the state of the race
+	 */
+	[[nodiscard]] TcpDataPacket MakeKeyframe() const;
+
+	/**
+	 * \brief Hands a parked session the new connection of its client and brings the client up to
+	 * date with a keyframe, all in the reply to the client's first message
+	 * \param newClient The new connection, which is removed either way
+	 * \param inData The e_ResumeSession message the client introduced itself with
+	 */
+	void ResumeSession(SessionHandle newClient, const TcpDataPacket& inData);
+
+	/**
+	 * \brief Removes a parked session and its car once it has run out of time
+	 * \param handle The table handle of the parked session
+	 * \param session The parked session, as found with the handle
+	 */
+	void ExpireParkedSession(SessionHandle handle, ClientSnapshot& session);
+
+	/**
+	 * \return A new random resume token, never 0
+	 */
+	[[nodiscard]] uint64_t MakeResumeToken();
+
 	
 	/**
 	 * \brief Checks to see if all of the racers have completed all the laps
 	 * \return True if the race has finished
 	 */
-	bool CheckGameOver();
+	[[nodiscard]] bool CheckGameOver() const;
+
+	/**
+	 * \brief Tells everybody the final placements once the race is over, only the first call does anything
+	 */
+	void FinishRace();
 	
 	/**
 	 * \brief Handles collision between clients. Updates their position across all
-	 * clients when the collision is resolved
+	 * clients when the collision is resolved. Pairs of player driven cars are left to
+	 * CompensateCollisions, which judges them when their updates arrive
 	 */
 	void CheckCollisionsBetweenClients();
 
 	/**
-	 * \brief Calculates the current order of players in the race. I.e. who is First all the
-	 * way to who is last
+	 * \brief Handles collision between a player's car and the others as the player saw them, with
+	 * the other cars put back where they were at the player's view time
+	 * \param car The index of the player's car, at the position they just sent
+	 * \param viewTime The server time the player was seeing the race at, from EstimateViewTime
+	 */
+	void CompensateCollisions(int car, int64_t viewTime);
+
+	/**
+	 * \brief The narrow phase of the collision detection, checks whether two cars are
+	 * actually touching and pushes them apart if they are
+	 * \param car The index of the first car
+	 * \param otherCar The index of the second car
+	 * \param otherPosition Where to test the second car, which may be in the past
+	 * \param otherAngle The angle to test the second car at in radians
+	 * \return True if the cars collided
+	 */
+	bool ResolveCollision(int car, int otherCar, const sf::Vector2f& otherPosition, float otherAngle);
+
+	/**
+	 * \brief Tells the clients of two cars that they collided and where they were pushed to
+	 * \param car The index of the first car
+	 * \param otherCar The index of the second car
+	 */
+	void SendCollision(int car, int otherCar);
+
+	/**
+	 * \brief Notes where a car is now in its history
+	 * \param car The index of the car
+	 */
+	void RecordHistory(int car);
+
+	/**
+	 * \brief Works out when a player was seeing the race when they sent an update, from the tick of
+	 * the newest move of another car they had been sent. A client that hasn't sent one is taken to
+	 * be a round trip behind, and nobody is taken further back than k_maxRewind
+	 * \param client The player's session
+	 * \param update The e_UpdatePosition the player sent
+	 * \param receivedAt When the update arrived, from ServerTime
+	 * \return The view time in microseconds of server time
+	 */
+	[[nodiscard]] int64_t EstimateViewTime(const ClientSnapshot& client, const TcpDataPacket& update, int64_t receivedAt) const;
+
+	/**
+	 * \brief Tells the clients whose place in the race has changed since the last tick
 	 */
 	void WorkOutTrackPlacements();
 	
 	/**
-	 * \brief Updates the AI controlled client
-	 * \param deltaTime The time between updates, for frame-rate independence
-	 * \param client The client that should be moved by the AI 
+	 * \brief Moves every AI controlled car as one batch for as many fixed physics steps as have
+	 * passed, then tells the clients where they moved
+	 * \param deltaTime The time since the last tick
+	 */
+	void AIMovement(float deltaTime);
+
+	/**
+	 * \brief Removes a car from the race, keeping m_carOwners in step with m_cars
+	 * \param car The index of the car to remove
 	 */
-	void AIMovement(float deltaTime, ClientSnapshot& client) const;
+	void RemoveCar(int car);
 	
 	/**
-	 * \brief Finds the index of the client in the connectedClients vector
-	 * via their username
+	 * \brief Finds the session of a connected or parked player via their username
 	 * \param username The username to look for
-	 * \return The index of the username to look for, -1 if the username can't
-	 * be found
+	 * \return The player's session, nullptr if the username can't be found
 	 */
-	[[nodiscard]] int FindClientIndex(const std::string& username) const;
+	[[nodiscard]] ClientSnapshot* FindRacer(const std::string& username);
 	
 	/**
-	 * \brief Finds out if the username is taken in the connectedClients vector
+	 * \brief Finds out if the username is taken by a connected client or a parked session
 	 * \param username The username to look for
 	 * \return True if the username is taken
 	 */
 	[[nodiscard]] bool IsUsernameTaken(const std::string& username) const;
+
+	/**
+	 * \return The lowest network ID that no connected client or parked session is using
+	 */
+	[[nodiscard]] uint16_t FindFreeNetworkId() const;
+
+	/**
+	 * \return The lowest place on the starting grid that no car in the room is using. Cars leave
+	 * the room before it races, so the places aren't always taken in order
+	 */
+	[[nodiscard]] int FindFreeGridSlot() const;
 	
 	/**
-	 * \brief Handles collision between the clients and the checkpoints around the map
-	 * \param client The client to check collisions of
+	 * \brief Handles collision between the cars and the checkpoints around the map. The movement
+	 * since the last update is tested as a segment against the gate of the next checkpoint only,
+	 * so fast cars can't skip a checkpoint and the finish line can't be counted twice
+	 * \param car The index of the car to check collisions of
+	 * \param previousPosition Where the car was before its latest update
+	 * \param viewTime The server time the car's driver was seeing the race at, finishers are placed by it
+	 */
+	void CheckIfClientHasPassedCheckPoint(int car, const sf::Vector2f& previousPosition, int64_t viewTime);
+
+	/**
+	 * \brief Works out how far through the race a car is from its position on the track centreline
+	 * \param car The index of the car to update
 	 */
-	void CheckIfClientHasPassedCheckPoint(ClientSnapshot& client);
+	void UpdateRaceProgress(int car);
 	
+	/**
+	 * \brief Sends a packet to a session without blocking. Whatever the socket can't take straight
+	 * away waits in the session's unsent bytes, so a client that stops reading only holds itself up
+	 * \param session The session to send to
+	 * \param packet The packet to send
+	 * \return False if the connection has gone, or so much is already waiting for the client that
+	 * the packet was dropped
+	 */
+	static bool SendPacket(ClientSnapshot& session, const sf::Packet& packet);
+
+	/**
+	 * \brief Sends as much of a session's unsent bytes as its socket will take
+	 * \param session The session to send to
+	 * \return The status of the socket
+	 */
+	static sf::Socket::Status FlushSession(ClientSnapshot& session);
+
 	/**
 	 * \brief Sends a packet to a connected client via TCP
 	 * \param dataToSend The TcpDataPacket to send to the client
 	 * \param receiver The username of the recipient of the message
-	 * \return True if the message was sent correctly
+	 * \return True if the message was sent correctly, or was dropped because the receiver's
+	 * session is parked
 	 */
 	[[nodiscard]] bool SendMessage(const TcpDataPacket& dataToSend, const std::string& receiver);
 	
 	/**
-	 * \brief Broadcasts a packet to every connected client
+	 * \brief Broadcasts a packet to every connected client and spectator
 	 * \param dataToSend The TcpDataPacket to be sent to every connected client
-	 * \return True if the broadcast was sent correctly
+	 * \return True if the broadcast was sent correctly to every player, a spectator
+	 * that can't be sent to doesn't count as a failure
+	 */
+	[[nodiscard]] bool BroadcastMessage(const TcpDataPacket& dataToSend);
+
+	/**
+	 * \return True if a player is connected or their session is parked
 	 */
-	[[nodiscard]] bool BroadcastMessage(const TcpDataPacket& dataToSend) const;
+	[[nodiscard]] bool HasRacers() const;
 };
@@ -1,9 +1,13 @@
 ﻿#include <cassert>
 
 #include "Server.h"
+#include "../Shared Files/Logger.h"
 
 int main()
 {
+	// Keep the console output away from the game loop, everything goes to the log file
+	logging::Logger::Get().Start("server.log");
+
 	auto s = Server::CreateServer(25565);
 
 	assert(s);
@@ -0,0 +1,84 @@
+#include "SessionTable.h"
+
+SessionTable::SessionTable(const int capacity) :
+	m_slots(capacity)
+{
+	m_freeSlots.reserve(capacity);
+	m_removedSlots.reserve(capacity);
+
+	// Hand out the lowest slots first
+	for (int i = capacity - 1; i >= 0; --i)
+	{
+		m_slots[i].handle.index = static_cast<uint16_t>(i);
+		m_freeSlots.push_back(static_cast<uint16_t>(i));
+	}
+}
+
+SessionHandle SessionTable::Acquire()
+{
+	if (m_freeSlots.empty())
+	{
+		return {};
+	}
+
+	Slot& slot = m_slots[m_freeSlots.back()];
+	m_freeSlots.pop_back();
+
+	slot.state = eSlotState::e_Live;
+	return slot.handle;
+}
+
+void SessionTable::Remove(const SessionHandle handle)
+{
+	if (!Get(handle))
+	{
+		return;
+	}
+
+	m_slots[handle.index].state = eSlotState::e_Removed;
+	m_removedSlots.push_back(handle.index);
+}
+
+void SessionTable::CollectRemoved()
+{
+	for (const uint16_t index : m_removedSlots)
+	{
+		Slot& slot = m_slots[index];
+
+		slot.session.socket->disconnect();
+		slot.session.Reset();
+
+		// Any handle still pointing at the slot is stale from now on
+		++slot.handle.generation;
+		slot.state = eSlotState::e_Free;
+
+		m_freeSlots.push_back(index);
+	}
+	m_removedSlots.clear();
+}
+
+ClientSnapshot* SessionTable::Get(const SessionHandle handle)
+{
+	if (handle.index >= m_slots.size())
+	{
+		return nullptr;
+	}
+
+	Slot& slot = m_slots[handle.index];
+	if (slot.state != eSlotState::e_Live || slot.handle.generation != handle.generation)
+	{
+		return nullptr;
+	}
+
+	return &slot.session;
+}
+
+int SessionTable::Count(const eSessionRole role) const
+{
+	int count = 0;
+	for (const Slot& slot : m_slots)
+	{
+		count += slot.state == eSlotState::e_Live && slot.session.role == role;
+	}
+	return count;
+}
@@ -0,0 +1,156 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "ClientSnapshot.h"
+
+/**
+ * \brief Refers to a session in the SessionTable. The generation tells a handle to a session that
+ * has since been removed apart from a handle to whichever session reuses its slot
+ */
+struct SessionHandle
+{
+	static constexpr uint16_t k_invalidIndex = 0xFFFF;
+
+	uint16_t index = k_invalidIndex;
+	uint16_t generation = 0;
+
+	/**
+	 * \return True if the handle refers to a slot, it may still be stale
+	 */
+	[[nodiscard]] bool IsValid() const { return index != k_invalidIndex; }
+};
+
+/**
+ * \brief The server's sessions, kept in a fixed amount of slots that are made once and reused, socket
+ * and all, so accepting and dropping connections doesn't allocate. Adding, removing and looking up a
+ * session by its handle never search. Removing is deferred: a removed session is skipped straight
+ * away, but its slot is only freed by CollectRemoved at the end of the tick, so removing a session
+ * while going through the table is safe
+ */
+class SessionTable
+{
+public:
+	/**
+	 * \param capacity The most sessions the table can hold at once
+	 */
+	explicit SessionTable(int capacity);
+
+	// Non-copyable and non-moveable
+	SessionTable(const SessionTable& other) = delete;
+	SessionTable& operator=(const SessionTable& other) = delete;
+
+	SessionTable(SessionTable&& other) = delete;
+	SessionTable& operator=(SessionTable&& other) = delete;
+
+	~SessionTable() = default;
+
+	/**
+	 * \brief Takes a free slot for a new session, which starts off as eSessionRole::e_Pending
+	 * \return The handle of the new session, invalid if every slot is in use
+	 */
+	[[nodiscard]] SessionHandle Acquire();
+
+	/**
+	 * \brief Removes a session, its slot is freed and its socket disconnected by CollectRemoved
+	 * \param handle The session to remove, nothing happens if it is stale
+	 */
+	void Remove(SessionHandle handle);
+
+	/**
+	 * \brief Frees the slots of the sessions removed since the last call, call at the end of the tick
+	 */
+	void CollectRemoved();
+
+	/**
+	 * \param handle The session to look up
+	 * \return The session, nullptr if the handle is stale or the session has been removed
+	 */
+	[[nodiscard]] ClientSnapshot* Get(SessionHandle handle);
+
+	/**
+	 * \brief Calls the visitor for every session that hasn't been removed
+	 * \tparam Visitor A callable taking a SessionHandle and a ClientSnapshot&
+	 * \param visitor Called once for each session, it may remove sessions
+	 */
+	template<typename Visitor>
+	void ForEach(Visitor&& visitor)
+	{
+		for (Slot& slot : m_slots)
+		{
+			if (slot.state == eSlotState::e_Live)
+			{
+				visitor(slot.handle, slot.session);
+			}
+		}
+	}
+
+	/**
+	 * \brief Calls the visitor for every session that hasn't been removed
+	 * \tparam Visitor A callable taking a SessionHandle and a const ClientSnapshot&
+	 * \param visitor Called once for each session
+	 */
+	template<typename Visitor>
+	void ForEach(Visitor&& visitor) const
+	{
+		for (const Slot& slot : m_slots)
+		{
+			if (slot.state == eSlotState::e_Live)
+			{
+				visitor(slot.handle, slot.session);
+			}
+		}
+	}
+
+	/**
+	 * \tparam Predicate A callable taking a const ClientSnapshot& and returning a bool
+	 * \param predicate What to look for
+	 * \return The handle of the first session that hasn't been removed and matches, invalid if none do
+	 */
+	template<typename Predicate>
+	[[nodiscard]] SessionHandle Find(Predicate&& predicate) const
+	{
+		for (const Slot& slot : m_slots)
+		{
+			if (slot.state == eSlotState::e_Live && predicate(slot.session))
+			{
+				return slot.handle;
+			}
+		}
+		return {};
+	}
+
+	/**
+	 * \param role The role to count
+	 * \return The amount of sessions with the role that haven't been removed
+	 */
+	[[nodiscard]] int Count(eSessionRole role) const;
+
+private:
+	enum class eSlotState : uint8_t
+	{
+		e_Free,
+		e_Live,
+		// Removed this tick, waiting for CollectRemoved
+		e_Removed
+	};
+
+	struct Slot
+	{
+		ClientSnapshot session;
+
+		// The handle of the session in the slot, the generation goes up every time the slot is freed
+		SessionHandle handle;
+
+		eSlotState state = eSlotState::e_Free;
+	};
+
+	// Made once, so the sessions never move and pointers to them stay valid while they are live
+	std::vector<Slot> m_slots;
+
+	// The indices of the free slots, used as a stack
+	std::vector<uint16_t> m_freeSlots;
+
+	// The indices of the slots removed since the last CollectRemoved
+	std::vector<uint16_t> m_removedSlots;
+};
@@ -0,0 +1,114 @@
+#include "SpatialGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// The neighbouring cells to compare against. Only half of the neighbours are visited,
+	// the other half visit this cell instead, so no pair is found twice
+	constexpr int NEIGHBOUR_OFFSETS[4][2]{
+		{ 1, 0 },
+		{ -1, 1 },
+		{ 0, 1 },
+		{ 1, 1 }
+	};
+} // anonymous namespace
+
+SpatialGrid::SpatialGrid(const float cellSize, const float worldWidth, const float worldHeight) :
+	m_cellSize(cellSize),
+	m_inverseCellSize(1.f / cellSize),
+	m_columns(std::max(1, static_cast<int>(std::ceil(worldWidth / cellSize)))),
+	m_rows(std::max(1, static_cast<int>(std::ceil(worldHeight / cellSize))))
+{
+	m_cellStarts.resize(m_columns * m_rows + 1, 0);
+}
+
+int SpatialGrid::CellIndex(const sf::Vector2f& position) const
+{
+	const int column = std::clamp(static_cast<int>(position.x * m_inverseCellSize), 0, m_columns - 1);
+	const int row = std::clamp(static_cast<int>(position.y * m_inverseCellSize), 0, m_rows - 1);
+	return row * m_columns + column;
+}
+
+void SpatialGrid::Sort(const int count)
+{
+	// Counting sort: count the objects in each cell, turn the counts into start offsets and then scatter
+	std::fill(m_cellStarts.begin(), m_cellStarts.end(), 0);
+
+	for (int i = 0; i < count; ++i)
+	{
+		m_cellStarts[m_itemCells[i] + 1]++;
+	}
+
+	for (size_t cell = 1; cell < m_cellStarts.size(); ++cell)
+	{
+		m_cellStarts[cell] += m_cellStarts[cell - 1];
+	}
+
+	m_cellItems.resize(count);
+
+	// Scatter backwards using the end of each cell as a cursor, leaving m_cellStarts as the starts again
+	for (int i = count - 1; i >= 0; --i)
+	{
+		m_cellItems[--m_cellStarts[m_itemCells[i] + 1]] = i;
+	}
+
+	// Every start was shifted down by one slot during the scatter, so shift them back
+	for (size_t cell = 0; cell + 1 < m_cellStarts.size(); ++cell)
+	{
+		m_cellStarts[cell] = m_cellStarts[cell + 1];
+	}
+	m_cellStarts.back() = count;
+}
+
+void SpatialGrid::FindPairs(std::vector<std::pair<int, int>>& pairs) const
+{
+	pairs.clear();
+
+	for (int row = 0; row < m_rows; ++row)
+	{
+		for (int column = 0; column < m_columns; ++column)
+		{
+			const int cell = row * m_columns + column;
+			const int begin = m_cellStarts[cell];
+			const int end = m_cellStarts[cell + 1];
+
+			if (begin == end)
+			{
+				continue;
+			}
+
+			// Pairs within the cell itself
+			for (int a = begin; a < end; ++a)
+			{
+				for (int b = a + 1; b < end; ++b)
+				{
+					pairs.emplace_back(m_cellItems[a], m_cellItems[b]);
+				}
+			}
+
+			// Pairs with the forward neighbours
+			for (const auto& offset : NEIGHBOUR_OFFSETS)
+			{
+				const int neighbourColumn = column + offset[0];
+				const int neighbourRow = row + offset[1];
+
+				if (neighbourColumn < 0 || neighbourColumn >= m_columns || neighbourRow >= m_rows)
+				{
+					continue;
+				}
+
+				const int neighbour = neighbourRow * m_columns + neighbourColumn;
+
+				for (int a = begin; a < end; ++a)
+				{
+					for (int b = m_cellStarts[neighbour]; b < m_cellStarts[neighbour + 1]; ++b)
+					{
+						pairs.emplace_back(m_cellItems[a], m_cellItems[b]);
+					}
+				}
+			}
+		}
+	}
+}
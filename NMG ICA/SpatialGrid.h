@@ -0,0 +1,77 @@
+#pragma once
+#include <utility>
+#include <vector>
+#include <SFML/System/Vector2.hpp>
+
+/**
+ * \brief A uniform grid over the world used as the broad phase for collisions. It is rebuilt
+ * every tick with a counting sort so building is O(N + cells), and neighbouring cells are visited
+ * in a fixed half-pattern so every pair of nearby objects is reported exactly once
+ */
+class SpatialGrid
+{
+public:
+	/**
+	 * \param cellSize The width and height of a cell, must be at least as big as the objects stored
+	 * \param worldWidth The width of the area covered by the grid
+	 * \param worldHeight The height of the area covered by the grid
+	 */
+	SpatialGrid(float cellSize, float worldWidth, float worldHeight);
+
+	/**
+	 * \brief Sorts the objects into the cells of the grid. Objects outside the world are clamped
+	 * into the nearest edge cell
+	 * \tparam GetPosition A callable taking an index and returning an sf::Vector2f
+	 * \param count The amount of objects to insert, they are referred to by index 0 to count - 1
+	 * \param getPosition Returns the position of an object
+	 */
+	template<typename GetPosition>
+	void Build(const int count, GetPosition&& getPosition)
+	{
+		m_itemCells.resize(count);
+
+		for (int i = 0; i < count; ++i)
+		{
+			m_itemCells[i] = CellIndex(getPosition(i));
+		}
+
+		Sort(count);
+	}
+
+	/**
+	 * \brief Finds every pair of objects in the same or neighbouring cells. Each pair is
+	 * emitted once with the lower cell visited first
+	 * \param pairs Cleared and filled with the candidate pairs
+	 */
+	void FindPairs(std::vector<std::pair<int, int>>& pairs) const;
+
+private:
+	// The size of each cell, and its inverse so building doesn't divide
+	float m_cellSize;
+	float m_inverseCellSize;
+
+	// The amount of cells across and down
+	int m_columns;
+	int m_rows;
+
+	// The cell each object was placed in
+	std::vector<int> m_itemCells;
+
+	// The start of each cell's run in m_cellItems, with one extra entry for the end of the last cell
+	std::vector<int> m_cellStarts;
+
+	// Object indices grouped by cell
+	std::vector<int> m_cellItems;
+
+	/**
+	 * \param position A position in the world
+	 * \return The index of the cell containing the position
+	 */
+	[[nodiscard]] int CellIndex(const sf::Vector2f& position) const;
+
+	/**
+	 * \brief Groups the objects by cell once m_itemCells has been filled
+	 * \param count The amount of objects
+	 */
+	void Sort(int count);
+};
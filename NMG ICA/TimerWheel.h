@@ -0,0 +1,307 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/**
+ * \brief Refers to a timer in a TimerWheel. The generation tells a handle to a timer that has
+ * fired or been cancelled apart from a handle to whichever timer reuses its node
+ */
+struct TimerHandle
+{
+	static constexpr uint32_t k_invalidIndex = 0xFFFFFFFF;
+
+	uint32_t index = k_invalidIndex;
+	uint32_t generation = 0;
+
+	/**
+	 * \return True if the handle refers to a node, the timer may have fired since
+	 */
+	[[nodiscard]] bool IsValid() const { return index != k_invalidIndex; }
+};
+
+/**
+ * \brief A hierarchical timing wheel. Time moves in fixed ticks, and each level is a ring of slots
+ * holding the timers due in that slot's span of time: the first level has a slot per tick, the next
+ * a slot per lap of the first level, and so on. When a level comes round to a slot, that slot's
+ * timers are spread down into the finer level below, so every timer is moved at most once per level
+ * before it fires. Scheduling and cancelling never search, the timers of a slot are an intrusive
+ * linked list through a pool of nodes that is reused, and advancing only looks at the slots that
+ * are due, however many timers there are
+ * \tparam Payload What a timer carries back to whoever handles it when it fires
+ */
+template<typename Payload>
+class TimerWheel
+{
+public:
+	/**
+	 * \param tickLength The length of a tick in seconds, the wheel's resolution
+	 * \param expectedTimers The amount of timers to make room for up front, more are made as needed
+	 */
+	TimerWheel(const float tickLength, const size_t expectedTimers) :
+		m_tickLength(tickLength),
+		m_now(0),
+		m_untickedTime(0.f),
+		m_freeNodes(k_invalidIndex)
+	{
+		m_nodes.reserve(expectedTimers);
+		for (auto& level : m_slots)
+		{
+			level.fill(k_invalidIndex);
+		}
+	}
+
+	/**
+	 * \brief Sets a timer going
+	 * \param delay The time until the timer fires in seconds, rounded up to a whole tick
+	 * \param payload What to hand back when the timer fires
+	 * \return The handle to cancel the timer with
+	 */
+	TimerHandle Schedule(const float delay, const Payload& payload)
+	{
+		const uint64_t ticks = static_cast<uint64_t>(std::ceil(std::max(delay, 0.f) / m_tickLength));
+
+		const uint32_t index = AllocateNode();
+		Node& node = m_nodes[index];
+		node.expiry = m_now + std::max<uint64_t>(ticks, 1);
+		node.payload = payload;
+
+		Insert(index);
+		return { index, node.generation };
+	}
+
+	/**
+	 * \brief Stops a timer from firing, nothing happens if it already fired or was cancelled
+	 * \param handle The timer to cancel, which is made invalid
+	 */
+	void Cancel(TimerHandle& handle)
+	{
+		if (IsPending(handle))
+		{
+			Unlink(handle.index);
+			FreeNode(handle.index);
+		}
+		handle = {};
+	}
+
+	/**
+	 * \param handle A timer
+	 * \return True if the timer hasn't fired or been cancelled yet
+	 */
+	[[nodiscard]] bool IsPending(const TimerHandle& handle) const
+	{
+		return handle.index < m_nodes.size() &&
+			m_nodes[handle.index].generation == handle.generation &&
+			m_nodes[handle.index].slot != k_invalidIndex;
+	}
+
+	/**
+	 * \brief Moves time on, firing every timer that comes due in order of the ticks they are due on
+	 * \tparam OnExpired A callable taking a const Payload&, it may schedule and cancel timers
+	 * \param deltaTime The time that has passed in seconds
+	 * \param onExpired Called once for each timer that fires
+	 */
+	template<typename OnExpired>
+	void Advance(const float deltaTime, OnExpired&& onExpired)
+	{
+		m_untickedTime += deltaTime;
+
+		while (m_untickedTime >= m_tickLength)
+		{
+			m_untickedTime -= m_tickLength;
+			++m_now;
+
+			// Coming round to the start of a lap spreads the next level's slot down, coarsest first
+			for (int level = k_levels - 1; level > 0; --level)
+			{
+				if ((m_now & LevelMask(level)) == 0)
+				{
+					Cascade(level, SlotOf(m_now, level));
+				}
+			}
+
+			// Fire everything in this tick's slot. Always taking the head means a handler can cancel
+			// any other timer in the slot without breaking the walk
+			uint32_t& head = m_slots[0][SlotOf(m_now, 0)];
+			while (head != k_invalidIndex)
+			{
+				const uint32_t index = head;
+				Unlink(index);
+
+				const Payload payload = m_nodes[index].payload;
+				FreeNode(index);
+
+				onExpired(payload);
+			}
+		}
+	}
+
+	/**
+	 * \return The time the wheel has moved through in seconds
+	 */
+	[[nodiscard]] double Now() const { return static_cast<double>(m_now) * m_tickLength; }
+
+private:
+	static constexpr uint32_t k_invalidIndex = TimerHandle::k_invalidIndex;
+
+	// Each level has 64 slots, so the four levels cover 64^4 ticks
+	static constexpr int k_slotBits = 6;
+	static constexpr int k_slotCount = 1 << k_slotBits;
+	static constexpr int k_levels = 4;
+	static constexpr uint64_t k_maxTicks = (uint64_t(1) << (k_slotBits * k_levels)) - 1;
+
+	struct Node
+	{
+		uint64_t expiry = 0;
+		Payload payload{};
+
+		// The neighbours in the slot's list, or the next free node while the node isn't in use
+		uint32_t previous = k_invalidIndex;
+		uint32_t next = k_invalidIndex;
+
+		// The level and slot the node is in, k_invalidIndex while it isn't scheduled
+		uint32_t slot = k_invalidIndex;
+
+		uint32_t generation = 0;
+	};
+
+	float m_tickLength;
+
+	// The amount of ticks that have passed, and the time that hasn't made up a whole tick yet
+	uint64_t m_now;
+	float m_untickedTime;
+
+	// The pool of nodes, used ones are in a slot's list and the rest are in the free list
+	std::vector<Node> m_nodes;
+	uint32_t m_freeNodes;
+
+	// The head of each slot's list
+	std::array<std::array<uint32_t, k_slotCount>, k_levels> m_slots;
+
+	/**
+	 * \param level A level of the wheel
+	 * \return The bits of the tick count below the level
+	 */
+	static constexpr uint64_t LevelMask(const int level)
+	{
+		return (uint64_t(1) << (k_slotBits * level)) - 1;
+	}
+
+	/**
+	 * \param tick A tick
+	 * \param level A level of the wheel
+	 * \return The slot of the level that the tick falls in
+	 */
+	static constexpr uint32_t SlotOf(const uint64_t tick, const int level)
+	{
+		return static_cast<uint32_t>((tick >> (k_slotBits * level)) & (k_slotCount - 1));
+	}
+
+	/**
+	 * \brief Puts a node in the slot for its expiry. The level is the finest one whose ring reaches
+	 * far enough ahead, timers further away than the whole wheel wait in the furthest slot
+	 * \param index The node to insert
+	 */
+	void Insert(const uint32_t index)
+	{
+		Node& node = m_nodes[index];
+
+		uint64_t ticks = node.expiry - m_now;
+		if (ticks > k_maxTicks)
+		{
+			ticks = k_maxTicks;
+			node.expiry = m_now + ticks;
+		}
+
+		int level = 0;
+		while (level < k_levels - 1 && ticks >= (uint64_t(1) << (k_slotBits * (level + 1))))
+		{
+			++level;
+		}
+
+		const uint32_t slot = SlotOf(node.expiry, level);
+		uint32_t& head = m_slots[level][slot];
+
+		node.slot = static_cast<uint32_t>(level * k_slotCount) + slot;
+		node.previous = k_invalidIndex;
+		node.next = head;
+		if (head != k_invalidIndex)
+		{
+			m_nodes[head].previous = index;
+		}
+		head = index;
+	}
+
+	/**
+	 * \brief Takes a node out of its slot's list
+	 * \param index The node to unlink
+	 */
+	void Unlink(const uint32_t index)
+	{
+		Node& node = m_nodes[index];
+
+		if (node.previous != k_invalidIndex)
+		{
+			m_nodes[node.previous].next = node.next;
+		} else
+		{
+			m_slots[node.slot / k_slotCount][node.slot % k_slotCount] = node.next;
+		}
+
+		if (node.next != k_invalidIndex)
+		{
+			m_nodes[node.next].previous = node.previous;
+		}
+
+		node.slot = k_invalidIndex;
+	}
+
+	/**
+	 * \brief Moves every timer in a slot down to the finer levels
+	 * \param level The level of the slot
+	 * \param slot The slot to spread down
+	 */
+	void Cascade(const int level, const uint32_t slot)
+	{
+		uint32_t index = m_slots[level][slot];
+		m_slots[level][slot] = k_invalidIndex;
+
+		while (index != k_invalidIndex)
+		{
+			const uint32_t next = m_nodes[index].next;
+			Insert(index);
+			index = next;
+		}
+	}
+
+	/**
+	 * \return A node from the free list, or a new one if the list is empty
+	 */
+	uint32_t AllocateNode()
+	{
+		if (m_freeNodes == k_invalidIndex)
+		{
+			m_nodes.emplace_back();
+			return static_cast<uint32_t>(m_nodes.size() - 1);
+		}
+
+		const uint32_t index = m_freeNodes;
+		m_freeNodes = m_nodes[index].next;
+		return index;
+	}
+
+	/**
+	 * \brief Returns a node to the free list, making every handle to it stale
+	 * \param index The node to free
+	 */
+	void FreeNode(const uint32_t index)
+	{
+		Node& node = m_nodes[index];
+		++node.generation;
+		node.slot = k_invalidIndex;
+		node.next = m_freeNodes;
+		m_freeNodes = index;
+	}
+};
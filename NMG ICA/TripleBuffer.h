@@ -0,0 +1,78 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * \brief Hands the latest version of a value from one writer thread to one reader thread without either
+ * of them ever waiting. The writer fills the back buffer and swaps it into the middle, the reader swaps
+ * the middle into the front when something new has been published. Versions the reader never got to
+ * are simply written over, so the reader always sees the newest complete one
+ * \tparam T The type of the value, it must be default constructible. Each of the three buffers keeps
+ * its own contents, so the writer has to fill in every part of the back buffer each time
+ */
+template<typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() :
+		m_back(0),
+		m_middle(1),
+		m_front(2)
+	{
+	}
+
+	// Non-copyable and non-moveable
+	TripleBuffer(const TripleBuffer& other) = delete;
+	TripleBuffer& operator=(const TripleBuffer& other) = delete;
+
+	TripleBuffer(TripleBuffer&& other) = delete;
+	TripleBuffer& operator=(TripleBuffer&& other) = delete;
+
+	~TripleBuffer() = default;
+
+	/**
+	 * \return The buffer to fill in, must only be used by the writer thread
+	 */
+	T& WriteBuffer() { return m_buffers[m_back]; }
+
+	/**
+	 * \brief Publishes the back buffer to the reader and takes the old middle buffer to write into next
+	 */
+	void Publish()
+	{
+		m_back = m_middle.exchange(static_cast<uint8_t>(m_back | k_newFlag), std::memory_order_acq_rel) & k_indexMask;
+	}
+
+	/**
+	 * \brief Swaps the newest published buffer to the front, must only be called by the reader thread
+	 * \return False if nothing was published since the last call, the front buffer is left alone then
+	 */
+	bool Consume()
+	{
+		if ((m_middle.load(std::memory_order_relaxed) & k_newFlag) == 0)
+		{
+			return false;
+		}
+
+		m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & k_indexMask;
+		return true;
+	}
+
+	/**
+	 * \return The buffer taken by the last Consume, must only be used by the reader thread
+	 */
+	const T& ReadBuffer() const { return m_buffers[m_front]; }
+
+private:
+	// The middle index carries a flag for whether it holds something the reader hasn't seen
+	static constexpr uint8_t k_indexMask = 0x3;
+	static constexpr uint8_t k_newFlag = 0x4;
+
+	std::array<T, 3> m_buffers;
+
+	// The writer's buffer, the shared buffer and the reader's buffer, each on its own cache line
+	alignas(64) uint8_t m_back;
+	alignas(64) std::atomic<uint8_t> m_middle;
+	alignas(64) uint8_t m_front;
+};
@@ -0,0 +1,462 @@
+#include "Relay.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#include "../Shared Files/Logger.h"
+#include "../Shared Files/NetworkClock.h"
+
+namespace
+{
+	// The longest the relay waits for the server before it sends the spectators what they're owed
+	constexpr int POLL_INTERVAL_MILLISECONDS = 2;
+
+	// Spectators only send to say goodbye, so they are read from now and then rather than every update
+	const sf::Time SPECTATOR_READ_INTERVAL = sf::milliseconds(250);
+
+	// How long the relay waits for the server to let it spectate
+	const sf::Time CONNECTION_TIMEOUT = sf::seconds(10.f);
+
+	// How long a new connection has to ask to spectate before it is dropped
+	const sf::Time SPECTATOR_CONNECTION_TIMEOUT = sf::seconds(5.f);
+
+	// The most connections that can be waiting to ask to spectate at once
+	constexpr size_t MAX_PENDING_SPECTATORS = 64;
+
+	// The most spectators one relay takes
+	constexpr size_t MAX_SPECTATORS = 512;
+
+	// A spectator with more than this waiting to be sent is too far behind and starts again from a keyframe
+	constexpr size_t MAX_QUEUED_BYTES = 64 * 1024;
+} // anonymous namespace
+
+std::unique_ptr<Relay> Relay::CreateRelay(const std::string& name, const unsigned short serverPort, const unsigned short listenPort)
+{
+	std::unique_ptr<Relay> newRelay(new Relay(name));
+
+	// Abide by the factory pattern, only return a value if it was initialised correctly
+	if (newRelay->Initialise(serverPort, listenPort))
+	{
+		return newRelay;
+	}
+
+	return nullptr;
+}
+
+Relay::Relay(std::string name) :
+	m_name(std::move(name))
+{
+}
+
+bool Relay::Initialise(const unsigned short serverPort, const unsigned short listenPort)
+{
+	if (m_server.connect(sf::IpAddress::getLocalAddress(), serverPort) != sf::Socket::Done)
+	{
+		std::cout << "Unable to connect to the server at address: " << sf::IpAddress::getLocalAddress() << std::endl;
+		return false;
+	}
+
+	// Ask to spectate, the server answers with a keyframe of the race
+	sf::Packet outPacket;
+	outPacket << TcpDataPacket(eDataPacketType::e_SpectatorConnection, m_name);
+	m_server.send(outPacket);
+
+	sf::SocketSelector connectionSelector;
+	connectionSelector.add(m_server);
+
+	sf::Packet inPacket;
+	if (!connectionSelector.wait(CONNECTION_TIMEOUT) || m_server.receive(inPacket) != sf::Socket::Done)
+	{
+		std::cout << "The server didn't let the relay spectate" << std::endl;
+		return false;
+	}
+
+	TcpDataPacket inData;
+	inPacket >> inData;
+
+	if (inData.m_type != eDataPacketType::e_WorldSnapshot)
+	{
+		std::cout << "The server has no room for another spectator" << std::endl;
+		return false;
+	}
+
+	m_world = inData.m_worldSnapshot;
+
+	if (m_listener.listen(listenPort, sf::IpAddress::getLocalAddress()) != sf::Socket::Done)
+	{
+		std::cout << "Unable to listen for spectators on port " << listenPort << std::endl;
+		return false;
+	}
+
+	// Never block on the server, the spectators would miss their sends
+	m_server.setBlocking(false);
+
+	m_selector.add(m_listener);
+	m_selector.add(m_server);
+
+	std::cout << "Relay is spectating and listening to port " << listenPort << ", waiting for spectators... " << std::endl;
+	return true;
+}
+
+bool Relay::Update()
+{
+	if (m_selector.wait(sf::milliseconds(POLL_INTERVAL_MILLISECONDS)))
+	{
+		if (m_selector.isReady(m_listener))
+		{
+			AcceptSpectator();
+		}
+
+		if (m_selector.isReady(m_server) && !ReceiveFromServer())
+		{
+			LOG_WARNING("Lost the connection to the game server");
+			return false;
+		}
+	}
+
+	CheckPendingSpectators();
+
+	if (m_spectatorReadClock.getElapsedTime() >= SPECTATOR_READ_INTERVAL)
+	{
+		m_spectatorReadClock.restart();
+		CheckSpectators();
+	}
+
+	FlushSpectators();
+	return true;
+}
+
+void Relay::AcceptSpectator()
+{
+	auto socket = std::make_unique<sf::TcpSocket>();
+	if (m_listener.accept(*socket) != sf::Socket::Done)
+	{
+		LOG_WARNING("A spectator had an error connecting");
+		return;
+	}
+
+	if (m_pendingSpectators.size() >= MAX_PENDING_SPECTATORS)
+	{
+		LOG_WARNING("Too many connections are waiting to spectate, dropping a new one");
+		return;
+	}
+
+	// Their first message is waited for without blocking, the server and the spectators come first
+	socket->setBlocking(false);
+
+	PendingSpectator& pending = m_pendingSpectators.emplace_back();
+	pending.socket = std::move(socket);
+}
+
+void Relay::CheckPendingSpectators()
+{
+	for (auto pending = m_pendingSpectators.begin(); pending != m_pendingSpectators.end();)
+	{
+		// The first message says who they are, the same as it does on the server. The socket holds
+		// on to any part of it that has arrived until the rest comes
+		sf::Packet inPacket;
+		const sf::Socket::Status status = pending->socket->receive(inPacket);
+
+		if (status == sf::Socket::Done)
+		{
+			TcpDataPacket inData;
+			inPacket >> inData;
+
+			if (inData.m_type == eDataPacketType::e_SpectatorConnection)
+			{
+				AddSpectator(std::move(pending->socket), inData.m_userName);
+			} else
+			{
+				LOG_WARNING("A client connected to the relay without asking to spectate");
+			}
+		} else if (status == sf::Socket::Disconnected || status == sf::Socket::Error)
+		{
+			LOG_WARNING("A spectator had an error connecting");
+		} else if (pending->connectedClock.getElapsedTime() >= SPECTATOR_CONNECTION_TIMEOUT)
+		{
+			LOG_WARNING("A client connected to the relay but never asked to spectate");
+		} else
+		{
+			// Still waiting for the rest of it
+			++pending;
+			continue;
+		}
+
+		pending = m_pendingSpectators.erase(pending);
+	}
+}
+
+void Relay::AddSpectator(std::unique_ptr<sf::TcpSocket> socket, const std::string& username)
+{
+	if (m_spectators.size() >= MAX_SPECTATORS)
+	{
+		LOG_INFO("Maximum amount of spectators connected, rejecting {}", username);
+
+		// The socket doesn't block, the rejection is small enough to go in one send or not at all
+		sf::Packet maxSpectatorsPkt;
+		maxSpectatorsPkt << TcpDataPacket(eDataPacketType::e_MaxPlayers, globals::k_reservedServerUsername);
+		socket->send(maxSpectatorsPkt);
+		return;
+	}
+
+	Spectator& spectator = m_spectators.emplace_back();
+	spectator.socket = std::move(socket);
+	spectator.username = username;
+
+	// Start them off from where the race is now
+	Enqueue(spectator, Keyframe());
+
+	LOG_INFO("{} is spectating through the relay, there are {} spectators", spectator.username, static_cast<int>(m_spectators.size()));
+}
+
+bool Relay::ReceiveFromServer()
+{
+	sf::Packet inPacket;
+	TcpDataPacket inData;
+
+	while (true)
+	{
+		switch (m_server.receive(inPacket))
+		{
+		case sf::Socket::Done:
+		{
+			// Reading the message doesn't change the packet's data, so it is passed on exactly as it came
+			inPacket >> inData;
+
+			// Heartbeats are about the relay's own connection, so they are answered rather than passed on
+			if (inData.m_type == eDataPacketType::e_Heartbeat)
+			{
+				AnswerHeartbeat(inData, network_clock::now());
+				break;
+			}
+
+			ApplyToWorld(inData);
+
+			const Frame frame = MakeFrame(inPacket.getData(), inPacket.getDataSize());
+			for (auto& spectator : m_spectators)
+			{
+				Enqueue(spectator, frame);
+			}
+			break;
+		}
+
+		case sf::Socket::Disconnected:
+			return false;
+
+		default:
+			// Nothing more has fully arrived yet
+			return true;
+		}
+	}
+}
+
+void Relay::AnswerHeartbeat(const TcpDataPacket& heartbeat, const int64_t receivedAt)
+{
+	// The server's send time goes back with how long the relay held on to it
+	TcpDataPacket answer(eDataPacketType::e_Heartbeat, m_name);
+	answer.m_originateTime = heartbeat.m_transmitTime;
+	answer.m_receiveTime = receivedAt;
+	answer.m_transmitTime = network_clock::now();
+
+	sf::Packet heartbeatPkt;
+	heartbeatPkt << answer;
+
+	// The server socket doesn't block, but the answer is tiny so finish it off rather than queue it
+	sf::Socket::Status status = m_server.send(heartbeatPkt);
+	while (status == sf::Socket::Partial)
+	{
+		status = m_server.send(heartbeatPkt);
+	}
+
+	if (status != sf::Socket::Done)
+	{
+		LOG_WARNING("Failed to answer a heartbeat from the server");
+	}
+}
+
+void Relay::ApplyToWorld(const TcpDataPacket& data)
+{
+	WorldCar* car = m_world.FindCar(data.m_networkId);
+
+	switch (data.m_type)
+	{
+	case eDataPacketType::e_WorldSnapshot:
+		m_world = data.m_worldSnapshot;
+		break;
+
+	case eDataPacketType::e_NewClient:
+		if (!car)
+		{
+			WorldCar& newCar = m_world.cars.emplace_back();
+			newCar.networkId = data.m_networkId;
+			newCar.username = data.m_userName;
+			newCar.x = data.m_x;
+			newCar.y = data.m_y;
+			newCar.angle = data.m_angle;
+			newCar.red = data.m_red;
+			newCar.green = data.m_green;
+			newCar.blue = data.m_blue;
+		}
+		break;
+
+	case eDataPacketType::e_UpdatePosition:
+		if (car)
+		{
+			car->x = data.m_x;
+			car->y = data.m_y;
+			car->angle = data.m_angle;
+		}
+		break;
+
+	case eDataPacketType::e_CollisionData:
+		if (car)
+		{
+			car->x = data.m_x;
+			car->y = data.m_y;
+		}
+		break;
+
+	case eDataPacketType::e_ClientDisconnected:
+		m_world.cars.erase(std::remove_if(m_world.cars.begin(), m_world.cars.end(), [&data](const WorldCar& worldCar)
+			{
+				return worldCar.networkId == data.m_networkId;
+			}), m_world.cars.end());
+		break;
+
+	case eDataPacketType::e_StartGame:
+		m_world.gameStarted = true;
+		break;
+
+	case eDataPacketType::e_GameOver:
+		m_world.gameOver = true;
+		m_world.placementOrder = data.m_placementOrder.m_racePositions;
+		break;
+
+	default:
+		// Nothing that a spectator sees
+		return;
+	}
+
+	m_keyframe.reset();
+}
+
+void Relay::Enqueue(Spectator& spectator, const Frame& frame)
+{
+	if (spectator.queuedBytes + frame->size() <= MAX_QUEUED_BYTES)
+	{
+		spectator.queue.push_back(frame);
+		spectator.queuedBytes += frame->size();
+		return;
+	}
+
+	LOG_DEBUG("{} fell too far behind, starting them again from a keyframe", spectator.username);
+
+	// Only a frame that is partly sent has to be finished, or the spectator would get half a message
+	while (spectator.queue.size() > (spectator.frontOffset > 0 ? 1u : 0u))
+	{
+		spectator.queuedBytes -= spectator.queue.back()->size();
+		spectator.queue.pop_back();
+	}
+
+	// The world already includes the frame, so the keyframe takes its place
+	const Frame& keyframe = Keyframe();
+	spectator.queue.push_back(keyframe);
+	spectator.queuedBytes += keyframe->size();
+}
+
+void Relay::FlushSpectators()
+{
+	for (auto& spectator : m_spectators)
+	{
+		while (!spectator.queue.empty())
+		{
+			const std::vector<char>& frame = *spectator.queue.front();
+
+			std::size_t sent = 0;
+			const sf::Socket::Status status = spectator.socket->send(
+				frame.data() + spectator.frontOffset, frame.size() - spectator.frontOffset, sent);
+
+			spectator.frontOffset += sent;
+
+			if (spectator.frontOffset == frame.size())
+			{
+				spectator.queuedBytes -= frame.size();
+				spectator.queue.pop_front();
+				spectator.frontOffset = 0;
+				continue;
+			}
+
+			if (status == sf::Socket::Disconnected || status == sf::Socket::Error)
+			{
+				spectator.disconnected = true;
+			}
+
+			// The socket can't take any more for now
+			break;
+		}
+	}
+
+	const auto removed = std::remove_if(m_spectators.begin(), m_spectators.end(), [](const Spectator& spectator)
+		{
+			return spectator.disconnected;
+		});
+
+	for (auto spectator = removed; spectator != m_spectators.end(); ++spectator)
+	{
+		LOG_INFO("The spectator {} left the relay", spectator->username);
+	}
+
+	m_spectators.erase(removed, m_spectators.end());
+}
+
+void Relay::CheckSpectators()
+{
+	char buffer[256];
+
+	for (auto& spectator : m_spectators)
+	{
+		// Spectators never send input, anything they do send is thrown away
+		std::size_t received = 0;
+		sf::Socket::Status status;
+		do
+		{
+			status = spectator.socket->receive(buffer, sizeof(buffer), received);
+		} while (status == sf::Socket::Done);
+
+		if (status == sf::Socket::Disconnected)
+		{
+			spectator.disconnected = true;
+		}
+	}
+}
+
+const Relay::Frame& Relay::Keyframe()
+{
+	if (!m_keyframe)
+	{
+		TcpDataPacket keyframe(eDataPacketType::e_WorldSnapshot, globals::k_reservedServerUsername);
+		keyframe.m_worldSnapshot = m_world;
+
+		sf::Packet packet;
+		packet << keyframe;
+		m_keyframe = MakeFrame(packet.getData(), packet.getDataSize());
+	}
+
+	return m_keyframe;
+}
+
+Relay::Frame Relay::MakeFrame(const void* data, const size_t size)
+{
+	auto frame = std::make_shared<std::vector<char>>(sizeof(uint32_t) + size);
+
+	// An sf::Packet starts with its size as a big endian 32 bit number
+	const auto length = static_cast<uint32_t>(size);
+	(*frame)[0] = static_cast<char>((length >> 24) & 0xFF);
+	(*frame)[1] = static_cast<char>((length >> 16) & 0xFF);
+	(*frame)[2] = static_cast<char>((length >> 8) & 0xFF);
+	(*frame)[3] = static_cast<char>(length & 0xFF);
+
+	std::copy_n(static_cast<const char*>(data), size, frame->data() + sizeof(uint32_t));
+	return frame;
+}
@@ -0,0 +1,187 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include <SFML/Network.hpp>
+
+#include "../Shared Files/Data.h"
+#include "../Shared Files/WorldSnapshot.h"
+
+/**
+ * \brief Stands between the game server and the audience. The relay watches the race as one of the
+ * server's few spectators and passes every message on to as many spectators as connect to it, so the
+ * server sends the same amount however many people are watching. Each message is framed once and the
+ * frame is shared by the queues of every spectator, which are sent without blocking so one slow
+ * spectator can't hold up the rest. The relay keeps its own copy of the race from the messages it
+ * passes on, so a spectator who joins late, or falls too far behind, starts from a keyframe of it
+ */
+class Relay
+{
+public:
+	/**
+	 * \brief Returns a heap allocated Relay object if initialisation was successful
+	 * \param name The name the relay spectates under
+	 * \param serverPort The port the game server is hosted on
+	 * \param listenPort The port to take spectators on
+	 * \return A unique_ptr if initialisation was successful, nullptr if not
+	 */
+	static std::unique_ptr<Relay> CreateRelay(const std::string& name, unsigned short serverPort, unsigned short listenPort);
+
+	/**
+	 * \brief Takes new spectators and passes on whatever the server has sent,
+	 * waiting a moment for something to happen first
+	 * \return False once the connection to the server has been lost
+	 */
+	bool Update();
+
+	// Non-copyable and non-moveable
+	Relay(const Relay& other) = delete;
+	Relay& operator=(const Relay& other) = delete;
+
+	Relay(Relay&& other) = delete;
+	Relay& operator=(Relay&& other) = delete;
+
+	~Relay() = default;
+
+private:
+	// A message with its length in front, ready to be written to a socket as it is. Every queue
+	// it is in shares the one copy
+	using Frame = std::shared_ptr<const std::vector<char>>;
+
+	/**
+	 * \brief A spectator watching through the relay
+	 */
+	struct Spectator
+	{
+		std::unique_ptr<sf::TcpSocket> socket;
+		std::string username;
+
+		// The frames waiting to be sent, how much of the first one has gone and how many bytes are waiting
+		std::deque<Frame> queue;
+		size_t frontOffset = 0;
+		size_t queuedBytes = 0;
+
+		// Flag for whether the spectator has gone and should be removed
+		bool disconnected = false;
+	};
+
+	/**
+	 * \brief A connection that hasn't said who it is yet
+	 */
+	struct PendingSpectator
+	{
+		std::unique_ptr<sf::TcpSocket> socket;
+
+		// How long ago the connection was accepted
+		sf::Clock connectedClock;
+	};
+
+	// The name the relay spectates under
+	std::string m_name;
+
+	// The connection to the game server
+	sf::TcpSocket m_server;
+
+	// Takes new spectators
+	sf::TcpListener m_listener;
+
+	// Wakes the relay up for the server and the listener. The spectators aren't in it, a selector
+	// only holds 64 sockets on Windows
+	sf::SocketSelector m_selector;
+
+	std::vector<Spectator> m_spectators;
+
+	// Connections waiting for their first message, read without blocking so a silent one can't
+	// hold up the race for everyone else
+	std::vector<PendingSpectator> m_pendingSpectators;
+
+	// The race as the relay has seen it, kept up to date from the messages passed on
+	WorldSnapshot m_world;
+
+	// A keyframe of m_world, made when it's needed and thrown away when the world changes
+	Frame m_keyframe;
+
+	// When the spectators were last read from
+	sf::Clock m_spectatorReadClock;
+
+	explicit Relay(std::string name);
+
+	/**
+	 * \brief Connects to the game server as a spectator and starts listening for spectators
+	 * \param serverPort The port the game server is hosted on
+	 * \param listenPort The port to take spectators on
+	 * \return True if the relay was initialised
+	 */
+	bool Initialise(unsigned short serverPort, unsigned short listenPort);
+
+	/**
+	 * \brief Accepts a new connection, which waits in m_pendingSpectators until it asks to spectate
+	 */
+	void AcceptSpectator();
+
+	/**
+	 * \brief Reads the first message of every pending connection, adding the ones that ask to spectate
+	 * and dropping the ones that don't, or that take too long to say
+	 */
+	void CheckPendingSpectators();
+
+	/**
+	 * \brief Adds a spectator and queues a keyframe to start them off, if there is room for them
+	 * \param socket The spectator's connection, which doesn't block
+	 * \param username The name the spectator asked to spectate under
+	 */
+	void AddSpectator(std::unique_ptr<sf::TcpSocket> socket, const std::string& username);
+
+	/**
+	 * \brief Reads everything the server has sent, keeps the world up to date and queues it for the spectators
+	 * \return False if the server disconnected
+	 */
+	bool ReceiveFromServer();
+
+	/**
+	 * \brief Answers the server's heartbeat, so it knows the relay is still there and can time
+	 * the round trip
+	 * \param heartbeat The heartbeat from the server
+	 * \param receivedAt When the heartbeat arrived, on the relay's clock
+	 */
+	void AnswerHeartbeat(const TcpDataPacket& heartbeat, int64_t receivedAt);
+
+	/**
+	 * \brief Keeps the relay's copy of the race up to date
+	 * \param data A message from the server
+	 */
+	void ApplyToWorld(const TcpDataPacket& data);
+
+	/**
+	 * \brief Queues a frame for a spectator. A spectator that has too much waiting is started
+	 * again from a keyframe instead, as they will never catch up
+	 * \param spectator The spectator to send to
+	 * \param frame The frame to send
+	 */
+	void Enqueue(Spectator& spectator, const Frame& frame);
+
+	/**
+	 * \brief Sends as much of every spectator's queue as their sockets will take, and removes the
+	 * spectators who have gone
+	 */
+	void FlushSpectators();
+
+	/**
+	 * \brief Reads from the spectators so their disconnections are noticed, throwing away anything they send
+	 */
+	void CheckSpectators();
+
+	/**
+	 * \return A keyframe of the race as the relay has seen it
+	 */
+	const Frame& Keyframe();
+
+	/**
+	 * \brief Frames a message the same way an sf::Packet is framed, so spectators receive it as a packet
+	 * \param data The contents of the packet
+	 * \param size The size of the contents in bytes
+	 * \return The frame
+	 */
+	static Frame MakeFrame(const void* data, size_t size);
+};
@@ -0,0 +1,25 @@
+#include <iostream>
+
+#include "Relay.h"
+#include "../Shared Files/Logger.h"
+
+int main()
+{
+	// Keep the console output away from the relay loop, everything goes to the log file
+	logging::Logger::Get().Start("relay.log");
+
+	auto relay = Relay::CreateRelay("RELAY", 25565, globals::spectators::k_relayPort);
+
+	if (!relay)
+	{
+		std::cout << "Unable to start the relay" << std::endl;
+		return 1;
+	}
+
+	// Keep passing the race on until the server goes away
+	while (relay->Update())
+	{
+	}
+
+	std::cout << "The game server has gone, the relay is stopping" << std::endl;
+}
@@ -0,0 +1,46 @@
+#include "CarPhysics.h"
+
+#include <string>
+
+#include "FastMath.h"
+#include "../NMG ICA/Globals.h"
+
+namespace car_physics
+{
+	void step(CarState& state, const CarInput& input)
+	{
+		// Turning, the turn for a step is worked out once so it's the same value the AI batch uses
+		const float turn = globals::cars::k_carTurnSpeed * k_fixedStep;
+		if (input.steer > 0)
+		{
+			state.angle = state.angle + turn;
+		}
+		else if (input.steer < 0)
+		{
+			state.angle = state.angle + -turn;
+		}
+
+		// Driving along the heading
+		if (input.throttle != 0)
+		{
+			const float distance = input.throttle > 0 ? state.speed * k_fixedStep : -state.speed * k_fixedStep;
+			state.position.x = state.position.x + fast_math::fast_sin(state.angle) * distance;
+			state.position.y = state.position.y - fast_math::fast_cos(state.angle) * distance;
+		}
+
+		// Keep the car on the screen
+		const float width = static_cast<float>(globals::game::k_screenWidth);
+		const float height = static_cast<float>(globals::game::k_screenHeight);
+		state.position.x = state.position.x < 0.f ? 0.f : (state.position.x > width ? width : state.position.x);
+		state.position.y = state.position.y < 0.f ? 0.f : (state.position.y > height ? height : state.position.y);
+	}
+
+	uint64_t hash_state(const CarState& state, uint64_t hash)
+	{
+		hash = hash_combine(hash, state.position.x);
+		hash = hash_combine(hash, state.position.y);
+		hash = hash_combine(hash, state.angle);
+		hash = hash_combine(hash, state.speed);
+		return hash;
+	}
+} // namespace car_physics
@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <SFML/System/Vector2.hpp>
+
+/**
+ * \brief The one movement step used for every car, the player's on the client and the AI's on the
+ * server. It always advances by the same fixed step and only uses adds, multiplies and the
+ * polynomial trig in fast_math, so the same inputs give bit-identical results on every build as long
+ * as the compiler doesn't fuse multiplies into adds (/fp:precise, -ffp-contract=off). The SIMD AI
+ * kernel in AIDriverBatch performs the same operations in the same order
+ */
+namespace car_physics
+{
+	// The length of every physics step in seconds
+	constexpr float k_fixedStep = 1.f / 60.f;
+
+	// The most time a single frame can catch up on, so a long stall doesn't run hundreds of steps
+	constexpr float k_maxCatchUp = 0.25f;
+
+	// The starting value of the state hashes
+	constexpr uint64_t k_hashSeed = 14695981039346656037ull;
+
+	/**
+	 * \brief The controls for a car during one step
+	 */
+	struct CarInput
+	{
+		// -1 to turn anticlockwise, 1 to turn clockwise, 0 to go straight
+		int8_t steer;
+
+		// 1 to drive forwards, -1 to reverse, 0 to stay still
+		int8_t throttle;
+	};
+
+	/**
+	 * \brief Everything the step needs to know about a car
+	 */
+	struct CarState
+	{
+		sf::Vector2f position;
+
+		// The heading in radians, 0 is facing up the screen
+		float angle;
+
+		// How fast the car drives, set from the surface it is on before each step
+		float speed;
+	};
+
+	/**
+	 * \brief Moves a car on by one fixed step. The car turns first and then drives along its new
+	 * heading, and is kept on the screen
+	 * \param state The car to move
+	 * \param input The controls for this step
+	 */
+	void step(CarState& state, const CarInput& input);
+
+	/**
+	 * \brief Mixes 32 bits into a hash with FNV-1a
+	 * \param hash The hash so far
+	 * \param bits The bits to mix in
+	 * \return The new hash
+	 */
+	inline uint64_t hash_combine(uint64_t hash, const uint32_t bits)
+	{
+		for (int byte = 0; byte < 4; ++byte)
+		{
+			hash ^= (bits >> (byte * 8)) & 0xFFu;
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	/**
+	 * \brief Mixes the exact bits of a float into a hash, so two states only hash the same if they
+	 * are bit-identical
+	 * \param hash The hash so far
+	 * \param value The value to mix in
+	 * \return The new hash
+	 */
+	inline uint64_t hash_combine(const uint64_t hash, const float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return hash_combine(hash, bits);
+	}
+
+	/**
+	 * \param hash The hash so far
+	 * \param value The value to mix in
+	 * \return The new hash
+	 */
+	inline uint64_t hash_combine(const uint64_t hash, const int32_t value)
+	{
+		return hash_combine(hash, static_cast<uint32_t>(value));
+	}
+
+	/**
+	 * \brief Hashes a car, used to check that the client and server agree without sending the
+	 * whole state
+	 * \param state The car to hash
+	 * \param hash The hash so far, to chain cars together
+	 * \return The new hash
+	 */
+	uint64_t hash_state(const CarState& state, uint64_t hash = k_hashSeed);
+} // namespace car_physics
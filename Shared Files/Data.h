@@ -1,6 +1,7 @@
 #pragma once
 #include <SFML/Graphics.hpp>
 #include "Globals.h"
+#include "WorldSnapshot.h"
 
 /**
  * \brief The types of data sent via the TcpPacket struct
@@ -23,7 +24,31 @@ enum class eDataPacketType : uint8_t
 	e_LapCompleted,
 	e_Overtaken,
 	e_RaceCompleted,
-	e_GameOver
+	e_GameOver,
+	// Sent instead of e_FirstConnection by a client that only wants to watch
+	e_SpectatorConnection,
+	// A keyframe of the whole race for spectators
+	e_WorldSnapshot,
+	// Sent instead of e_FirstConnection by a player whose connection dropped, with the resume
+	// token from their e_UserNameConfirmation
+	e_ResumeSession,
+	// The reply to e_ResumeSession, a keyframe of the race and a new resume token
+	e_SessionResumed,
+	// The reply to e_ResumeSession when the session has expired or the token is wrong
+	e_ResumeRejected,
+	// Sent by the server now and then and sent straight back, so a dead connection is noticed. It
+	// also measures the round trip time: the server's send time comes back with the time the
+	// client held on to it
+	e_Heartbeat,
+	// Sent by a client now and then with the time it was sent, to measure how far its clock is
+	// from the server's
+	e_ClockRequest,
+	// The reply to e_ClockRequest, the client's time back with when the server received the
+	// request, when it answered and the server tick it answered on
+	e_ClockResponse,
+	// The reply to e_FirstConnection while a race is on or the room is full, with the player's place
+	// in the queue as the position. An e_UserNameConfirmation follows once the next room has room
+	e_Queued
 };
 
 // Sending enums via sf::Packet https://en.sfml-dev.org/forums/index.php?topic=17075.0
@@ -87,18 +112,25 @@ struct TcpDataPacket
 {
 	TcpDataPacket() :
 		m_type(eDataPacketType::e_None),
+		m_networkId(globals::k_serverNetworkId),
 		m_x(0.f),
 		m_y(0.f),
 		m_angle(0.f),
 		m_red(0),
 		m_green(0),
 		m_blue(0),
-		m_positionInRace(0)
+		m_positionInRace(0),
+		m_resumeToken(0),
+		m_originateTime(0),
+		m_receiveTime(0),
+		m_transmitTime(0),
+		m_serverTick(0)
 	{
 	}
 
 	TcpDataPacket(const eDataPacketType type, const std::string& userName, const float x = 0.f, const float y = 0.f, const float angle = 0.f, const sf::Color& colour = sf::Color::Red) :
 		m_type(type),
+		m_networkId(globals::k_serverNetworkId),
 		m_userName(userName),
 		m_x(x),
 		m_y(y),
@@ -106,12 +138,18 @@ struct TcpDataPacket
 		m_red(static_cast<uint8_t>(colour.r)),
 		m_green(static_cast<uint8_t>(colour.g)),
 		m_blue(static_cast<uint8_t>(colour.b)),
-		m_positionInRace(0)
+		m_positionInRace(0),
+		m_resumeToken(0),
+		m_originateTime(0),
+		m_receiveTime(0),
+		m_transmitTime(0),
+		m_serverTick(0)
 	{
 	}
 
 	TcpDataPacket(const eDataPacketType type, const std::string& userName, const sf::Color& colour) :
 		m_type(type),
+		m_networkId(globals::k_serverNetworkId),
 		m_userName(userName),
 		m_x(0.f),
 		m_y(0.f),
@@ -119,12 +157,18 @@ struct TcpDataPacket
 		m_red(static_cast<uint8_t>(colour.r)),
 		m_green(static_cast<uint8_t>(colour.g)),
 		m_blue(static_cast<uint8_t>(colour.b)),
-		m_positionInRace(0)
+		m_positionInRace(0),
+		m_resumeToken(0),
+		m_originateTime(0),
+		m_receiveTime(0),
+		m_transmitTime(0),
+		m_serverTick(0)
 	{
 	}
 
 	TcpDataPacket(const eDataPacketType type, const std::string& username, const sf::Vector2f& position, const std::string& playerCollidedWith) :
 		m_type(type),
+		m_networkId(globals::k_serverNetworkId),
 		m_userName(username),
 		m_x(position.x),
 		m_y(position.y),
@@ -133,12 +177,18 @@ struct TcpDataPacket
 		m_green(0),
 		m_blue(0),
 		m_positionInRace(0),
-		m_playerCollidedWith(playerCollidedWith)
+		m_playerCollidedWith(playerCollidedWith),
+		m_resumeToken(0),
+		m_originateTime(0),
+		m_receiveTime(0),
+		m_transmitTime(0),
+		m_serverTick(0)
 	{
 	}
 
 	TcpDataPacket(const eDataPacketType type, const std::string& username, const int positionInRace) :
 		m_type(type),
+		m_networkId(globals::k_serverNetworkId),
 		m_userName(username),
 		m_x(0.f),
 		m_y(0.f),
@@ -146,12 +196,18 @@ struct TcpDataPacket
 		m_red(0),
 		m_green(0),
 		m_blue(0),
-		m_positionInRace(positionInRace)
+		m_positionInRace(positionInRace),
+		m_resumeToken(0),
+		m_originateTime(0),
+		m_receiveTime(0),
+		m_transmitTime(0),
+		m_serverTick(0)
 	{
 	}
 
 	TcpDataPacket(const eDataPacketType type, const std::string& username, const std::vector<std::string>& placementOrder) :
 		m_type(type),
+		m_networkId(globals::k_serverNetworkId),
 		m_userName(username),
 		m_x(0.f),
 		m_y(0.f),
@@ -160,11 +216,19 @@ struct TcpDataPacket
 		m_green(0),
 		m_blue(0),
 		m_positionInRace(0),
-		m_placementOrder(placementOrder)
+		m_placementOrder(placementOrder),
+		m_resumeToken(0),
+		m_originateTime(0),
+		m_receiveTime(0),
+		m_transmitTime(0),
+		m_serverTick(0)
 	{
 	}
 
 	eDataPacketType m_type;
+	// The ID the server gave the player the message is about, so clients can find the player
+	// without looking up the username
+	uint16_t m_networkId;
 	std::string m_userName;
 	float m_x;
 	float m_y;
@@ -175,16 +239,107 @@ struct TcpDataPacket
 	int m_positionInRace;
 	std::string m_playerCollidedWith;
 	PlacementOrder m_placementOrder; // TODO: add the default constructor to the initialiser lists 
+	// Only sent with e_UserNameConfirmation, e_ResumeSession and e_SessionResumed, 0 means no token
+	uint64_t m_resumeToken;
+	// Only sent with e_Heartbeat, e_ClockRequest and e_ClockResponse, the times in microseconds
+	// that the exchange was sent by the side that started it, received by the other side and
+	// answered, each on the clock of the side that took it
+	int64_t m_originateTime;
+	int64_t m_receiveTime;
+	int64_t m_transmitTime;
+	// Only sent with e_ClockResponse and e_UpdatePosition, the server tick the message was sent on.
+	// A client's e_UpdatePosition sends back the tick of the newest move of another car it had shown
+	uint32_t m_serverTick;
+	// Only sent with e_WorldSnapshot and e_SessionResumed
+	WorldSnapshot m_worldSnapshot;
 };
 
+/**
+ * \param type The type of a TcpDataPacket
+ * \return True if packets of the type carry a resume token
+ */
+inline bool carries_resume_token(const eDataPacketType type)
+{
+	return type == eDataPacketType::e_UserNameConfirmation ||
+		type == eDataPacketType::e_ResumeSession ||
+		type == eDataPacketType::e_SessionResumed;
+}
+
+/**
+ * \param type The type of a TcpDataPacket
+ * \return True if packets of the type carry the times of a clock exchange
+ */
+inline bool carries_timestamps(const eDataPacketType type)
+{
+	return type == eDataPacketType::e_Heartbeat ||
+		type == eDataPacketType::e_ClockRequest ||
+		type == eDataPacketType::e_ClockResponse;
+}
+
+/**
+ * \param type The type of a TcpDataPacket
+ * \return True if packets of the type carry the server tick they were sent on
+ */
+inline bool carries_server_tick(const eDataPacketType type)
+{
+	return type == eDataPacketType::e_ClockResponse || type == eDataPacketType::e_UpdatePosition;
+}
+
+/**
+ * \param type The type of a TcpDataPacket
+ * \return True if packets of the type carry a keyframe of the whole race
+ */
+inline bool carries_world_snapshot(const eDataPacketType type)
+{
+	return type == eDataPacketType::e_WorldSnapshot || type == eDataPacketType::e_SessionResumed;
+}
+
 inline sf::Packet operator<<(sf::Packet& packet, const TcpDataPacket& dp)
 {
-	return packet << dp.m_type << dp.m_userName << dp.m_x << dp.m_y << dp.m_angle <<
+	packet << dp.m_type << dp.m_networkId << dp.m_userName << dp.m_x << dp.m_y << dp.m_angle <<
 		dp.m_red << dp.m_green << dp.m_blue << dp.m_positionInRace << dp.m_playerCollidedWith << dp.m_placementOrder;
+
+	// Only the messages that need them carry the token, the times and the whole world, so every other
+	// message stays the same size
+	if (carries_resume_token(dp.m_type))
+	{
+		packet << dp.m_resumeToken;
+	}
+	if (carries_timestamps(dp.m_type))
+	{
+		packet << dp.m_originateTime << dp.m_receiveTime << dp.m_transmitTime;
+	}
+	if (carries_server_tick(dp.m_type))
+	{
+		packet << dp.m_serverTick;
+	}
+	if (carries_world_snapshot(dp.m_type))
+	{
+		packet << dp.m_worldSnapshot;
+	}
+	return packet;
 }
 
 inline sf::Packet operator>>(sf::Packet& packet, TcpDataPacket& dp)
 {
-	return packet >> dp.m_type >> dp.m_userName >> dp.m_x >> dp.m_y >> dp.m_angle >>
+	packet >> dp.m_type >> dp.m_networkId >> dp.m_userName >> dp.m_x >> dp.m_y >> dp.m_angle >>
 		dp.m_red >> dp.m_green >> dp.m_blue >> dp.m_positionInRace >> dp.m_playerCollidedWith >> dp.m_placementOrder;
+
+	if (carries_resume_token(dp.m_type))
+	{
+		packet >> dp.m_resumeToken;
+	}
+	if (carries_timestamps(dp.m_type))
+	{
+		packet >> dp.m_originateTime >> dp.m_receiveTime >> dp.m_transmitTime;
+	}
+	if (carries_server_tick(dp.m_type))
+	{
+		packet >> dp.m_serverTick;
+	}
+	if (carries_world_snapshot(dp.m_type))
+	{
+		packet >> dp.m_worldSnapshot;
+	}
+	return packet;
 }
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+#include <cmath>
+
+/**
+ * \brief Cheap trigonometry shared by the scalar and SIMD code. Every function is a fixed sequence of
+ * adds and multiplies so the SIMD kernels in AIDriverBatch can mirror them lane for lane
+ */
+namespace fast_math
+{
+	constexpr float k_pi = 3.14159265358979f;
+	constexpr float k_halfPi = 1.57079632679490f;
+	constexpr float k_twoPi = 6.28318530717959f;
+	constexpr float k_inverseTwoPi = 0.159154943091895f;
+
+	// Taylor coefficients of sin(x) up to x^11. On [-pi/2, pi/2] the truncation error is below 6e-8,
+	// so after range reduction the absolute error is within a few float ulps of 1 for angles
+	// of a sensible size (|x| < 1000 keeps it below 1e-5)
+	constexpr float k_sinC3 = -1.f / 6.f;
+	constexpr float k_sinC5 = 1.f / 120.f;
+	constexpr float k_sinC7 = -1.f / 5040.f;
+	constexpr float k_sinC9 = 1.f / 362880.f;
+	constexpr float k_sinC11 = -1.f / 39916800.f;
+
+	/**
+	 * \brief Wraps an angle into [-pi, pi]
+	 * \param x The angle in radians
+	 * \return The equivalent angle in [-pi, pi]
+	 */
+	inline float wrap_angle(const float x)
+	{
+		return x - std::nearbyint(x * k_inverseTwoPi) * k_twoPi;
+	}
+
+	/**
+	 * \brief Approximates sin(x)
+	 * \param x The angle in radians
+	 * \return The sine of the angle
+	 */
+	inline float fast_sin(const float x)
+	{
+		float t = wrap_angle(x);
+
+		// Fold into [-pi/2, pi/2] where the polynomial is accurate, sin(pi - x) == sin(x)
+		t = t > k_halfPi ? k_pi - t : t;
+		t = t < -k_halfPi ? -k_pi - t : t;
+
+		const float t2 = t * t;
+		return t + t * t2 * (k_sinC3 + t2 * (k_sinC5 + t2 * (k_sinC7 + t2 * (k_sinC9 + t2 * k_sinC11))));
+	}
+
+	/**
+	 * \brief Approximates cos(x)
+	 * \param x The angle in radians
+	 * \return The cosine of the angle
+	 */
+	inline float fast_cos(const float x)
+	{
+		return fast_sin(x + k_halfPi);
+	}
+} // namespace fast_math
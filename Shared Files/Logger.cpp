@@ -0,0 +1,193 @@
+#include "Logger.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+	// How long the logging thread sleeps for when there is nothing to write
+	constexpr std::chrono::milliseconds k_idleSleep{ 2 };
+
+	/**
+	 * \brief Converts the level into a fixed width label for the log file
+	 * \param level The level to convert
+	 * \return The label for the level
+	 */
+	const char* level_to_string(const eLogLevel level)
+	{
+		switch (level)
+		{
+		case eLogLevel::e_Debug:
+			return "DEBUG";
+		case eLogLevel::e_Info:
+			return "INFO ";
+		case eLogLevel::e_Warning:
+			return "WARN ";
+		case eLogLevel::e_Error:
+			return "ERROR";
+		}
+		return "?????";
+	}
+
+	/**
+	 * \brief Appends a captured argument to the end of the line
+	 * \param argument The argument to append
+	 * \param line The line being built
+	 */
+	void append_argument(const logging::LogArgument& argument, std::string& line)
+	{
+		char buffer[32];
+
+		switch (argument.type)
+		{
+		case logging::LogArgument::eType::e_Int:
+			std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(argument.i));
+			line += buffer;
+			break;
+		case logging::LogArgument::eType::e_UnsignedInt:
+			std::snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(argument.u));
+			line += buffer;
+			break;
+		case logging::LogArgument::eType::e_Float:
+			std::snprintf(buffer, sizeof(buffer), "%g", argument.f);
+			line += buffer;
+			break;
+		case logging::LogArgument::eType::e_Bool:
+			line += argument.b ? "true" : "false";
+			break;
+		case logging::LogArgument::eType::e_String:
+			line += argument.s;
+			break;
+		}
+	}
+} // anonymous namespace
+
+namespace logging
+{
+	Logger& Logger::Get()
+	{
+		static Logger logger;
+		return logger;
+	}
+
+	Logger::Logger() :
+		m_droppedMessages(0),
+		m_running(false),
+		m_startTime(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count())
+	{
+	}
+
+	Logger::~Logger()
+	{
+		Stop();
+	}
+
+	bool Logger::Start(const std::string& filePath)
+	{
+		if (m_running)
+		{
+			return false;
+		}
+
+		m_file.open(filePath, std::ios::out | std::ios::trunc);
+		if (!m_file.is_open())
+		{
+			return false;
+		}
+
+		m_running = true;
+		m_thread = std::thread(&Logger::Run, this);
+		return true;
+	}
+
+	void Logger::Stop()
+	{
+		if (!m_running)
+		{
+			return;
+		}
+
+		m_running = false;
+		if (m_thread.joinable())
+		{
+			m_thread.join();
+		}
+
+		m_file.close();
+	}
+
+	void Logger::Run()
+	{
+		std::string line;
+		line.reserve(256);
+
+		while (m_running)
+		{
+			if (!Drain(line))
+			{
+				// Only flush once the burst is over so the disk is written in big chunks
+				m_file.flush();
+				std::this_thread::sleep_for(k_idleSleep);
+			}
+		}
+
+		// Write out whatever was logged while stopping
+		Drain(line);
+		m_file.flush();
+	}
+
+	bool Logger::Drain(std::string& line)
+	{
+		bool wroteAnything = false;
+
+		while (m_buffer.TryPop([&](const LogRecord& record) { Format(record, line); }))
+		{
+			m_file << line;
+			wroteAnything = true;
+		}
+
+		const uint64_t dropped = m_droppedMessages.exchange(0, std::memory_order_relaxed);
+		if (dropped > 0)
+		{
+			m_file << "[logger] " << dropped << " messages were dropped as the buffer was full\n";
+		}
+
+		return wroteAnything;
+	}
+
+	void Logger::Format(const LogRecord& record, std::string& line) const
+	{
+		line.clear();
+
+		char prefix[48];
+		std::snprintf(prefix, sizeof(prefix), "[%12.6f] %s ",
+			static_cast<double>(record.timestamp - m_startTime) / 1e9, level_to_string(record.level));
+		line += prefix;
+
+		// Substitute each {} with the next argument
+		int argumentIndex = 0;
+		for (const char* c = record.format; *c != '\0'; ++c)
+		{
+			if (c[0] == '{' && c[1] == '}' && argumentIndex < record.argumentCount)
+			{
+				append_argument(record.arguments[argumentIndex++], line);
+				++c;
+			} else
+			{
+				line += *c;
+			}
+		}
+
+		line += '\n';
+	}
+
+	void Logger::CaptureString(LogArgument& argument, const char* string, const size_t length)
+	{
+		argument.type = LogArgument::eType::e_String;
+
+		const size_t copyLength = std::min(length, k_maxStringArgumentLength);
+		std::memcpy(argument.s, string, copyLength);
+		argument.s[copyLength] = '\0';
+	}
+} // namespace logging
@@ -0,0 +1,236 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include "RingBuffer.h"
+
+/**
+ * \brief How severe a logged message is. Anything below NMG_LOG_LEVEL is compiled out
+ */
+enum class eLogLevel : uint8_t
+{
+	e_Debug,
+	e_Info,
+	e_Warning,
+	e_Error
+};
+
+// The lowest level that gets compiled in, 0 = Debug, 1 = Info, 2 = Warning, 3 = Error
+#ifndef NMG_LOG_LEVEL
+#ifdef NDEBUG
+#define NMG_LOG_LEVEL 1
+#else
+#define NMG_LOG_LEVEL 0
+#endif
+#endif
+
+namespace logging
+{
+	constexpr eLogLevel k_compileTimeLevel = static_cast<eLogLevel>(NMG_LOG_LEVEL);
+
+	// The most arguments a single message can take
+	constexpr int k_maxArguments = 4;
+
+	// Strings longer than this get truncated when they're captured, usernames fit comfortably
+	constexpr size_t k_maxStringArgumentLength = 31;
+
+	// How many messages can be waiting to be written before new ones get dropped
+	constexpr size_t k_ringBufferSize = 4096;
+
+	/**
+	 * \brief A single captured argument. Arguments are stored in binary form and only
+	 * turned into text on the logging thread
+	 */
+	struct LogArgument
+	{
+		enum class eType : uint8_t
+		{
+			e_Int,
+			e_UnsignedInt,
+			e_Float,
+			e_Bool,
+			e_String
+		};
+
+		eType type;
+
+		union
+		{
+			int64_t i;
+			uint64_t u;
+			double f;
+			bool b;
+			char s[k_maxStringArgumentLength + 1];
+		};
+	};
+
+	/**
+	 * \brief Everything needed to format a message later on. The format has to be a
+	 * string literal as only its pointer is stored
+	 */
+	struct LogRecord
+	{
+		const char* format;
+		int64_t timestamp;
+		eLogLevel level;
+		uint8_t argumentCount;
+		LogArgument arguments[k_maxArguments];
+	};
+
+	/**
+	 * \brief An asynchronous logger. Producers capture the format pointer and the raw arguments into a
+	 * lock-free ring buffer and return straight away, a background thread formats the messages and
+	 * writes them to disk. If the buffer is ever full the message is dropped rather than blocking the game
+	 */
+	class Logger
+	{
+	public:
+		/**
+		 * \return The logger shared by the whole program
+		 */
+		static Logger& Get();
+
+		/**
+		 * \brief Opens the log file and starts the thread that writes to it
+		 * \param filePath The file to write the log to, it is overwritten
+		 * \return True if the file was opened
+		 */
+		bool Start(const std::string& filePath);
+
+		/**
+		 * \brief Writes everything still in the buffer and stops the logging thread
+		 */
+		void Stop();
+
+		/**
+		 * \brief Captures a message into the ring buffer. Each {} in the format is replaced by the next argument
+		 * \param level The severity of the message
+		 * \param format A string literal describing the message
+		 * \param args The values to substitute into the format
+		 */
+		template<size_t N, typename... Args>
+		void Log(const eLogLevel level, const char (&format)[N], const Args&... args)
+		{
+			static_assert(sizeof...(Args) <= k_maxArguments, "Too many arguments passed to the logger");
+
+			const int64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+
+			const bool pushed = m_buffer.TryPush([&](LogRecord& record)
+				{
+					record.format = format;
+					record.timestamp = timestamp;
+					record.level = level;
+					record.argumentCount = static_cast<uint8_t>(sizeof...(Args));
+
+					[[maybe_unused]] int index = 0;
+					(CaptureArgument(record.arguments[index++], args), ...);
+				});
+
+			if (!pushed)
+			{
+				m_droppedMessages.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		// Non-copyable and non-moveable
+		Logger(const Logger& other) = delete;
+		Logger& operator=(const Logger& other) = delete;
+
+		Logger(Logger&& other) = delete;
+		Logger& operator=(Logger&& other) = delete;
+
+		~Logger();
+
+	private:
+		// The messages waiting to be written
+		MpscRingBuffer<LogRecord, k_ringBufferSize> m_buffer;
+
+		// The count of messages that were thrown away because the buffer was full
+		std::atomic<uint64_t> m_droppedMessages;
+
+		// Flag for whether the logging thread should keep running
+		std::atomic<bool> m_running;
+
+		// The thread that drains the buffer
+		std::thread m_thread;
+
+		// The file that the log is written to
+		std::ofstream m_file;
+
+		// When the logger was started, timestamps are written relative to this
+		int64_t m_startTime;
+
+		Logger();
+
+		/**
+		 * \brief The body of the logging thread, drains the buffer until the logger is stopped
+		 */
+		void Run();
+
+		/**
+		 * \brief Writes every message currently in the buffer to the file
+		 * \param line A scratch string, reused between messages to avoid allocating
+		 * \return True if any messages were written
+		 */
+		bool Drain(std::string& line);
+
+		/**
+		 * \brief Turns a captured record into a line of text
+		 * \param record The record to format
+		 * \param line The string to write the formatted message into
+		 */
+		void Format(const LogRecord& record, std::string& line) const;
+
+		template<typename T>
+		static void CaptureArgument(LogArgument& argument, const T& value)
+		{
+			if constexpr (std::is_same_v<T, bool>)
+			{
+				argument.type = LogArgument::eType::e_Bool;
+				argument.b = value;
+			} else if constexpr (std::is_enum_v<T>)
+			{
+				argument.type = LogArgument::eType::e_Int;
+				argument.i = static_cast<int64_t>(value);
+			} else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+			{
+				argument.type = LogArgument::eType::e_Int;
+				argument.i = value;
+			} else if constexpr (std::is_integral_v<T>)
+			{
+				argument.type = LogArgument::eType::e_UnsignedInt;
+				argument.u = value;
+			} else if constexpr (std::is_floating_point_v<T>)
+			{
+				argument.type = LogArgument::eType::e_Float;
+				argument.f = value;
+			} else if constexpr (std::is_same_v<T, std::string>)
+			{
+				CaptureString(argument, value.c_str(), value.size());
+			} else
+			{
+				static_assert(std::is_convertible_v<T, const char*>, "The logger can't capture this type");
+				const char* string = value;
+				CaptureString(argument, string, std::strlen(string));
+			}
+		}
+
+		static void CaptureString(LogArgument& argument, const char* string, size_t length);
+	};
+} // namespace logging
+
+// Logs a message at the given level. The whole statement is compiled out if the level is too low
+#define NMG_LOG(level, ...) \
+	do { if constexpr ((level) >= logging::k_compileTimeLevel) { logging::Logger::Get().Log((level), __VA_ARGS__); } } while (false)
+
+#define LOG_DEBUG(...) NMG_LOG(eLogLevel::e_Debug, __VA_ARGS__)
+#define LOG_INFO(...) NMG_LOG(eLogLevel::e_Info, __VA_ARGS__)
+#define LOG_WARNING(...) NMG_LOG(eLogLevel::e_Warning, __VA_ARGS__)
+#define LOG_ERROR(...) NMG_LOG(eLogLevel::e_Error, __VA_ARGS__)
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * \brief A read-only view of a whole file mapped into memory. The pages are shared with the
+ * operating system's file cache, so every process mapping the same file shares one copy
+ */
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	// Non-copyable, the mapping belongs to one object
+	MappedFile(const MappedFile& other) = delete;
+	MappedFile& operator=(const MappedFile& other) = delete;
+
+	/**
+	 * \brief Maps a file, closing any file that was already mapped
+	 * \param path The file to map
+	 * \return True if the file was mapped
+	 */
+	bool Open(const std::string& path);
+
+	/**
+	 * \brief Unmaps the file, Data() is invalid afterwards
+	 */
+	void Close();
+
+	/**
+	 * \return The start of the file in memory, nullptr if nothing is mapped
+	 */
+	[[nodiscard]] const uint8_t* Data() const { return m_data; }
+
+	/**
+	 * \return The size of the file in bytes
+	 */
+	[[nodiscard]] size_t Size() const { return m_size; }
+
+private:
+	const uint8_t* m_data;
+	size_t m_size;
+
+#ifdef _WIN32
+	// The handles that keep the mapping alive on Windows
+	void* m_file;
+	void* m_mapping;
+#endif
+};
@@ -0,0 +1,94 @@
+#include "NetworkClock.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	// How far each sample moves the smoothed round trip time and its deviation
+	constexpr double RTT_GAIN = 1.0 / 8.0;
+	constexpr double DEVIATION_GAIN = 1.0 / 4.0;
+} // anonymous namespace
+
+namespace network_clock
+{
+	int64_t now()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+} // namespace network_clock
+
+RttEstimator::RttEstimator() :
+	m_smoothed(0.0),
+	m_deviation(0.0),
+	m_minimum(0),
+	m_samples(0)
+{
+}
+
+void RttEstimator::AddSample(const int64_t rtt)
+{
+	if (rtt < 0)
+	{
+		return;
+	}
+
+	const double sample = static_cast<double>(rtt);
+
+	if (m_samples == 0)
+	{
+		m_smoothed = sample;
+		m_deviation = sample / 2.0;
+		m_minimum = rtt;
+	} else
+	{
+		// The deviation is updated with the old smoothed time, as RFC 6298 has it
+		m_deviation += DEVIATION_GAIN * (std::abs(m_smoothed - sample) - m_deviation);
+		m_smoothed += RTT_GAIN * (sample - m_smoothed);
+		m_minimum = std::min(m_minimum, rtt);
+	}
+
+	++m_samples;
+}
+
+ClockSync::ClockSync(const float tickLength) :
+	m_tickLength(network_clock::from_seconds(tickLength)),
+	m_sampleCount(0),
+	m_nextSample(0),
+	m_offset(0)
+{
+}
+
+void ClockSync::AddSample(const int64_t originate, const int64_t receive, const int64_t transmit, const int64_t destination)
+{
+	const int64_t delay = network_clock::round_trip(originate, receive, transmit, destination);
+	if (delay < 0)
+	{
+		return;
+	}
+
+	m_rtt.AddSample(delay);
+
+	Sample& sample = m_samples[m_nextSample];
+	sample.offset = ((receive - originate) + (transmit - destination)) / 2;
+	sample.delay = delay;
+
+	m_nextSample = (m_nextSample + 1) % k_filterSize;
+	m_sampleCount = std::min(m_sampleCount + 1, k_filterSize);
+
+	// Trust the exchange that spent the least time on the way
+	const auto best = std::min_element(m_samples.begin(), m_samples.begin() + m_sampleCount, [](const Sample& a, const Sample& b)
+		{
+			return a.delay < b.delay;
+		});
+	m_offset = best->offset;
+}
+
+uint32_t ClockSync::LocalToTick(const int64_t localTime) const
+{
+	const int64_t serverTime = std::max<int64_t>(LocalToServer(localTime), 0);
+	return static_cast<uint32_t>(std::min<int64_t>(serverTime / m_tickLength, std::numeric_limits<uint32_t>::max()));
+}
@@ -0,0 +1,166 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+/**
+ * \brief The clocks the client and server time their messages with. Every time sent over the network
+ * is in microseconds, the server's counted from when the server started so the two sides can be
+ * told apart, and the server's timeline is also split into ticks of car_physics::k_fixedStep
+ */
+namespace network_clock
+{
+	/**
+	 * \return The time on this machine's steady clock, in microseconds
+	 */
+	int64_t now();
+
+	/**
+	 * \param seconds A length of time in seconds
+	 * \return The length in microseconds
+	 */
+	constexpr int64_t from_seconds(const double seconds)
+	{
+		return static_cast<int64_t>(seconds * 1000000.0);
+	}
+
+	/**
+	 * \param microseconds A length of time in microseconds
+	 * \return The length in milliseconds
+	 */
+	constexpr float to_milliseconds(const int64_t microseconds)
+	{
+		return static_cast<float>(static_cast<double>(microseconds) / 1000.0);
+	}
+
+	/**
+	 * \param originate When the request left the side that measures, on its clock
+	 * \param receive When the request arrived at the other side, on the other side's clock
+	 * \param transmit When the answer left the other side, on the other side's clock
+	 * \param destination When the answer arrived back, on the measuring side's clock
+	 * \return The round trip time without the time the other side held on to the request
+	 */
+	constexpr int64_t round_trip(const int64_t originate, const int64_t receive, const int64_t transmit, const int64_t destination)
+	{
+		return (destination - originate) - (transmit - receive);
+	}
+} // namespace network_clock
+
+/**
+ * \brief Keeps a smoothed round trip time and its jitter the same way TCP does (RFC 6298): each
+ * sample moves the smoothed time an eighth of the way and the mean deviation a quarter of the way
+ */
+class RttEstimator
+{
+public:
+	RttEstimator();
+
+	/**
+	 * \param rtt A measured round trip time in microseconds, negative samples are ignored
+	 */
+	void AddSample(int64_t rtt);
+
+	/**
+	 * \return True once there has been a sample
+	 */
+	[[nodiscard]] bool HasSamples() const { return m_samples > 0; }
+
+	/**
+	 * \return The smoothed round trip time in milliseconds
+	 */
+	[[nodiscard]] float SmoothedRtt() const { return static_cast<float>(m_smoothed / 1000.0); }
+
+	/**
+	 * \return The smoothed mean deviation of the round trip time in milliseconds
+	 */
+	[[nodiscard]] float Jitter() const { return static_cast<float>(m_deviation / 1000.0); }
+
+	/**
+	 * \return The shortest round trip time measured in milliseconds
+	 */
+	[[nodiscard]] float MinimumRtt() const { return network_clock::to_milliseconds(m_minimum); }
+
+private:
+	// In microseconds
+	double m_smoothed;
+	double m_deviation;
+	int64_t m_minimum;
+
+	int m_samples;
+};
+
+/**
+ * \brief Works out how far the server's clock is from the local one, NTP style. Each exchange gives
+ * an offset that is only wrong by as much as the trip there and the trip back differ, so the
+ * estimate is the offset of the exchange with the shortest round trip out of the last few, as
+ * those are the ones least held up on the way
+ */
+class ClockSync
+{
+public:
+	/**
+	 * \param tickLength The length of a server tick in seconds
+	 */
+	explicit ClockSync(float tickLength);
+
+	/**
+	 * \brief Adds the four times of a request to the server and its answer
+	 * \param originate When the request was sent, on the local clock
+	 * \param receive When the server received it, on the server's clock
+	 * \param transmit When the server answered, on the server's clock
+	 * \param destination When the answer arrived, on the local clock
+	 */
+	void AddSample(int64_t originate, int64_t receive, int64_t transmit, int64_t destination);
+
+	/**
+	 * \return True once there has been an exchange with the server
+	 */
+	[[nodiscard]] bool IsSynchronised() const { return m_sampleCount > 0; }
+
+	/**
+	 * \return How far the server's clock is ahead of the local one, in microseconds
+	 */
+	[[nodiscard]] int64_t Offset() const { return m_offset; }
+
+	/**
+	 * \param serverTime A time on the server's clock
+	 * \return The same moment on the local clock
+	 */
+	[[nodiscard]] int64_t ServerToLocal(const int64_t serverTime) const { return serverTime - m_offset; }
+
+	/**
+	 * \param localTime A time on the local clock
+	 * \return The same moment on the server's clock
+	 */
+	[[nodiscard]] int64_t LocalToServer(const int64_t localTime) const { return localTime + m_offset; }
+
+	/**
+	 * \param localTime A time on the local clock
+	 * \return The server tick happening at that moment
+	 */
+	[[nodiscard]] uint32_t LocalToTick(int64_t localTime) const;
+
+	/**
+	 * \return The round trip times of the exchanges
+	 */
+	[[nodiscard]] const RttEstimator& Rtt() const { return m_rtt; }
+
+private:
+	// How many recent exchanges the offset is picked from
+	static constexpr int k_filterSize = 8;
+
+	struct Sample
+	{
+		int64_t offset = 0;
+		int64_t delay = 0;
+	};
+
+	int64_t m_tickLength;
+
+	std::array<Sample, k_filterSize> m_samples;
+	int m_sampleCount;
+	int m_nextSample;
+
+	int64_t m_offset;
+
+	RttEstimator m_rtt;
+};
@@ -0,0 +1,218 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * \brief A bounded, lock-free ring buffer that any number of threads can push into and a
+ * single thread pops from. Each cell carries a sequence number so producers claim a slot with one
+ * compare-and-swap and the consumer never has to take a lock. Based on Dmitry Vyukov's bounded MPMC queue
+ * \tparam T The type stored in the buffer, it must be default constructible
+ * \tparam Capacity The amount of cells in the buffer, must be a power of two
+ */
+template<typename T, size_t Capacity>
+class MpscRingBuffer
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "The capacity of the ring buffer must be a power of two");
+
+public:
+	MpscRingBuffer() :
+		m_enqueuePosition(0),
+		m_dequeuePosition(0)
+	{
+		for (size_t i = 0; i < Capacity; ++i)
+		{
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	// Non-copyable and non-moveable
+	MpscRingBuffer(const MpscRingBuffer& other) = delete;
+	MpscRingBuffer& operator=(const MpscRingBuffer& other) = delete;
+
+	MpscRingBuffer(MpscRingBuffer&& other) = delete;
+	MpscRingBuffer& operator=(MpscRingBuffer&& other) = delete;
+
+	~MpscRingBuffer() = default;
+
+	/**
+	 * \brief Claims a cell and lets the caller fill it in place, so nothing is copied
+	 * \tparam Writer A callable taking a T&
+	 * \param writer Fills in the claimed cell
+	 * \return False if the buffer was full, the writer is not called in that case
+	 */
+	template<typename Writer>
+	bool TryPush(Writer&& writer)
+	{
+		Cell* cell;
+		size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+
+		while (true)
+		{
+			cell = &m_cells[position & k_mask];
+			const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+			if (difference == 0)
+			{
+				// The cell is free, try to claim it before another producer does
+				if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			} else if (difference < 0)
+			{
+				// The consumer hasn't got to this cell yet, the buffer is full
+				return false;
+			} else
+			{
+				position = m_enqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		writer(cell->data);
+
+		// Publish the cell to the consumer
+		cell->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * \brief Reads the oldest cell in place and hands it back to the producers.
+	 * Must only ever be called from one thread
+	 * \tparam Reader A callable taking a T&
+	 * \param reader Reads the oldest cell
+	 * \return False if the buffer was empty
+	 */
+	template<typename Reader>
+	bool TryPop(Reader&& reader)
+	{
+		Cell& cell = m_cells[m_dequeuePosition & k_mask];
+		const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+
+		if (sequence != m_dequeuePosition + 1)
+		{
+			return false;
+		}
+
+		reader(cell.data);
+
+		cell.sequence.store(m_dequeuePosition + Capacity, std::memory_order_release);
+		++m_dequeuePosition;
+		return true;
+	}
+
+private:
+	static constexpr size_t k_mask = Capacity - 1;
+
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		T data;
+	};
+
+	std::array<Cell, Capacity> m_cells;
+
+	// Producers and the consumer live on separate cache lines so they don't fight over them
+	alignas(64) std::atomic<size_t> m_enqueuePosition;
+	alignas(64) size_t m_dequeuePosition;
+};
+
+/**
+ * \brief A bounded, lock-free ring buffer between exactly one producer thread and one consumer thread.
+ * Each side owns its own position and only reads the other's when its cached copy says the buffer
+ * looks full or empty, so in the steady state neither side touches the other's cache line
+ * \tparam T The type stored in the buffer, it must be default constructible
+ * \tparam Capacity The amount of cells in the buffer, must be a power of two
+ */
+template<typename T, size_t Capacity>
+class SpscRingBuffer
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "The capacity of the ring buffer must be a power of two");
+
+public:
+	SpscRingBuffer() :
+		m_writePosition(0),
+		m_cachedReadPosition(0),
+		m_readPosition(0),
+		m_cachedWritePosition(0)
+	{
+	}
+
+	// Non-copyable and non-moveable
+	SpscRingBuffer(const SpscRingBuffer& other) = delete;
+	SpscRingBuffer& operator=(const SpscRingBuffer& other) = delete;
+
+	SpscRingBuffer(SpscRingBuffer&& other) = delete;
+	SpscRingBuffer& operator=(SpscRingBuffer&& other) = delete;
+
+	~SpscRingBuffer() = default;
+
+	/**
+	 * \brief Lets the caller fill the next cell in place, so anything it owns can be reused.
+	 * Must only ever be called from the producer thread
+	 * \tparam Writer A callable taking a T&
+	 * \param writer Fills in the cell
+	 * \return False if the buffer was full, the writer is not called in that case
+	 */
+	template<typename Writer>
+	bool TryPush(Writer&& writer)
+	{
+		const size_t position = m_writePosition.load(std::memory_order_relaxed);
+
+		if (position - m_cachedReadPosition == Capacity)
+		{
+			m_cachedReadPosition = m_readPosition.load(std::memory_order_acquire);
+			if (position - m_cachedReadPosition == Capacity)
+			{
+				return false;
+			}
+		}
+
+		writer(m_cells[position & k_mask]);
+
+		// Publish the cell to the consumer
+		m_writePosition.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * \brief Reads the oldest cell in place and hands it back to the producer.
+	 * Must only ever be called from the consumer thread
+	 * \tparam Reader A callable taking a T&
+	 * \param reader Reads the oldest cell
+	 * \return False if the buffer was empty
+	 */
+	template<typename Reader>
+	bool TryPop(Reader&& reader)
+	{
+		const size_t position = m_readPosition.load(std::memory_order_relaxed);
+
+		if (position == m_cachedWritePosition)
+		{
+			m_cachedWritePosition = m_writePosition.load(std::memory_order_acquire);
+			if (position == m_cachedWritePosition)
+			{
+				return false;
+			}
+		}
+
+		reader(m_cells[position & k_mask]);
+
+		m_readPosition.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	static constexpr size_t k_mask = Capacity - 1;
+
+	std::array<T, Capacity> m_cells;
+
+	// The producer's position and its last look at the consumer's, on their own cache line
+	alignas(64) std::atomic<size_t> m_writePosition;
+	size_t m_cachedReadPosition;
+
+	// The consumer's position and its last look at the producer's
+	alignas(64) std::atomic<size_t> m_readPosition;
+	size_t m_cachedWritePosition;
+};
@@ -0,0 +1,50 @@
+#include "SurfaceMask.h"
+
+#include <string>
+
+#include "../NMG ICA/Globals.h"
+
+SurfaceMask::SurfaceMask() :
+	m_width(0),
+	m_height(0),
+	m_wordsPerRow(0),
+	m_words(nullptr)
+{
+}
+
+SurfaceMask::SurfaceMask(const int width, const int height, const uint32_t* words) :
+	m_width(width),
+	m_height(height),
+	m_wordsPerRow(WordsPerRow(width)),
+	m_words(words)
+{
+}
+
+eSurfaceType SurfaceMask::At(const sf::Vector2f& position) const
+{
+	return IsTrack(static_cast<int>(position.x), static_cast<int>(position.y)) ? eSurfaceType::e_Track : eSurfaceType::e_Grass;
+}
+
+void SurfaceMask::Lookup(const float* xs, const float* ys, const int count, eSurfaceType* surfaces) const
+{
+	for (int i = 0; i < count; ++i)
+	{
+		surfaces[i] = IsTrack(static_cast<int>(xs[i]), static_cast<int>(ys[i])) ? eSurfaceType::e_Track : eSurfaceType::e_Grass;
+	}
+}
+
+float SurfaceMask::SpeedOn(const eSurfaceType surface)
+{
+	return surface == eSurfaceType::e_Track ? globals::cars::k_carTrackSpeed : globals::cars::k_carGrassSpeed;
+}
+
+bool SurfaceMask::IsTrack(const int x, const int y) const
+{
+	// A single unsigned compare catches negative coordinates as well
+	if (static_cast<unsigned>(x) >= static_cast<unsigned>(m_width) || static_cast<unsigned>(y) >= static_cast<unsigned>(m_height))
+	{
+		return false;
+	}
+
+	return (m_words[y * m_wordsPerRow + (x >> 5)] >> (x & 31)) & 1u;
+}
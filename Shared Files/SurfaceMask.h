@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <SFML/System/Vector2.hpp>
+
+/**
+ * \brief The kind of ground at a point on the map
+ */
+enum class eSurfaceType : uint8_t
+{
+	e_Grass,
+	e_Track
+};
+
+/**
+ * \brief The surface of the map baked down to one bit per pixel, packed 32 pixels to a word. A
+ * lookup is a shift and a mask instead of reading an RGBA pixel and comparing colours, and the
+ * whole map takes 1/32 of the memory of the image it was baked from. The mask doesn't own its
+ * words, it looks straight into the track asset they were baked into. Shared by the client, to set
+ * the player's speed, and the server, to set the AI's speed
+ */
+class SurfaceMask
+{
+public:
+	/**
+	 * \brief An empty mask, everywhere is grass
+	 */
+	SurfaceMask();
+
+	/**
+	 * \param width The width of the map in pixels
+	 * \param height The height of the map in pixels
+	 * \param words WordsPerRow(width) * height words, a set bit is track. They must outlive the mask
+	 */
+	SurfaceMask(int width, int height, const uint32_t* words);
+
+	/**
+	 * \param width The width of the map in pixels
+	 * \return The amount of 32 bit words in each row of the mask
+	 */
+	static constexpr int WordsPerRow(const int width) { return (width + 31) / 32; }
+
+	/**
+	 * \param position A position on the map
+	 * \return The surface at that position, anywhere off the map counts as grass
+	 */
+	[[nodiscard]] eSurfaceType At(const sf::Vector2f& position) const;
+
+	/**
+	 * \brief Looks up the surface under many positions at once
+	 * \param xs The x coordinate of each position
+	 * \param ys The y coordinate of each position
+	 * \param count The amount of positions
+	 * \param surfaces Filled with the surface under each position
+	 */
+	void Lookup(const float* xs, const float* ys, int count, eSurfaceType* surfaces) const;
+
+	/**
+	 * \param surface The surface a car is driving on
+	 * \return How fast a car can go on that surface
+	 */
+	static float SpeedOn(eSurfaceType surface);
+
+	/**
+	 * \return The width of the mask in pixels
+	 */
+	[[nodiscard]] int Width() const { return m_width; }
+
+	/**
+	 * \return The height of the mask in pixels
+	 */
+	[[nodiscard]] int Height() const { return m_height; }
+
+private:
+	// The size of the map
+	int m_width;
+	int m_height;
+
+	// The amount of 32 bit words in each row of the mask
+	int m_wordsPerRow;
+
+	// One bit per pixel, set where the pixel is track
+	const uint32_t* m_words;
+
+	/**
+	 * \param x The column of the pixel
+	 * \param y The row of the pixel
+	 * \return True if the pixel is track, false if it's grass or off the map
+	 */
+	[[nodiscard]] bool IsTrack(int x, int y) const;
+};
@@ -0,0 +1,131 @@
+#include "TrackAsset.h"
+
+namespace
+{
+	// An empty header for a track that hasn't been loaded, so the counts read as 0
+	const track_format::Header EMPTY_HEADER{};
+
+	/**
+	 * \brief Checks that an array in the file sits wholly inside it and is aligned
+	 * \param offset Where the array starts
+	 * \param count The amount of elements
+	 * \param elementSize The size of each element
+	 * \param fileSize The size of the file
+	 * \return True if the array can be used in place
+	 */
+	bool section_fits(const uint32_t offset, const uint32_t count, const size_t elementSize, const size_t fileSize)
+	{
+		return offset % 4 == 0 && offset <= fileSize && count <= (fileSize - offset) / elementSize;
+	}
+} // anonymous namespace
+
+TrackAsset::TrackAsset() :
+	m_header(&EMPTY_HEADER),
+	m_checkPoints(nullptr),
+	m_spawnPoints(nullptr),
+	m_racingLine(nullptr)
+{
+}
+
+bool TrackAsset::LoadFromFile(const std::string& path)
+{
+	// Opening a new file unmaps the old one, so nothing can be pointing into it
+	Detach();
+
+	if (!m_file.Open(path))
+	{
+		return false;
+	}
+
+	if (!Attach(m_file.Data(), m_file.Size()))
+	{
+		m_file.Close();
+		return false;
+	}
+
+	m_bakedAsset.clear();
+	return true;
+}
+
+bool TrackAsset::LoadFromMemory(std::vector<uint8_t> asset)
+{
+	Detach();
+	m_bakedAsset = std::move(asset);
+
+	if (!Attach(m_bakedAsset.data(), m_bakedAsset.size()))
+	{
+		m_bakedAsset.clear();
+		return false;
+	}
+
+	m_file.Close();
+	return true;
+}
+
+bool TrackAsset::Attach(const uint8_t* data, const size_t size)
+{
+	if (size < sizeof(track_format::Header))
+	{
+		return false;
+	}
+
+	const auto* header = reinterpret_cast<const track_format::Header*>(data);
+
+	if (header->magic != track_format::k_magic || header->version != track_format::k_version || header->fileSize != size)
+	{
+		return false;
+	}
+
+	// A lap needs a finish line and at least one other checkpoint, and the centreline runs through them all
+	if (header->checkPointCount < 2 || header->centrelinePointCount != header->checkPointCount || header->spawnPointCount == 0)
+	{
+		return false;
+	}
+
+	// The AI needs at least a triangle to drive around
+	if (header->racingLinePointCount < 3 || !(header->racingLineSpacing > 0.f))
+	{
+		return false;
+	}
+
+	const uint32_t surfaceWords = static_cast<uint32_t>(SurfaceMask::WordsPerRow(static_cast<int>(header->surfaceWidth))) * header->surfaceHeight;
+
+	if (!section_fits(header->checkPointsOffset, header->checkPointCount, sizeof(track_format::CheckPoint), size) ||
+		!section_fits(header->spawnPointsOffset, header->spawnPointCount, sizeof(track_format::SpawnPoint), size) ||
+		!section_fits(header->centrelinePointsOffset, header->centrelinePointCount, sizeof(track_format::CentrelinePoint), size) ||
+		!section_fits(header->racingLinePointsOffset, header->racingLinePointCount, sizeof(track_format::RacingLinePoint), size) ||
+		!section_fits(header->surfaceOffset, surfaceWords, sizeof(uint32_t), size))
+	{
+		return false;
+	}
+
+	m_header = header;
+	m_checkPoints = reinterpret_cast<const track_format::CheckPoint*>(data + header->checkPointsOffset);
+	m_spawnPoints = reinterpret_cast<const track_format::SpawnPoint*>(data + header->spawnPointsOffset);
+
+	m_centreline = TrackCentreline(
+		reinterpret_cast<const track_format::CentrelinePoint*>(data + header->centrelinePointsOffset),
+		static_cast<int>(header->centrelinePointCount),
+		header->trackLength
+	);
+
+	m_racingLine = reinterpret_cast<const track_format::RacingLinePoint*>(data + header->racingLinePointsOffset);
+
+	m_surface = SurfaceMask(
+		static_cast<int>(header->surfaceWidth),
+		static_cast<int>(header->surfaceHeight),
+		reinterpret_cast<const uint32_t*>(data + header->surfaceOffset)
+	);
+
+	return true;
+}
+
+void TrackAsset::Detach()
+{
+	m_header = &EMPTY_HEADER;
+	m_checkPoints = nullptr;
+	m_spawnPoints = nullptr;
+	m_centreline = TrackCentreline();
+	m_racingLine = nullptr;
+	m_surface = SurfaceMask();
+}
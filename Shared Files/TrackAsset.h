@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "SurfaceMask.h"
+#include "TrackCentreline.h"
+#include "TrackFormat.h"
+
+/**
+ * \brief Everything the game knows about a track: the checkpoints, the starting grid, the
+ * centreline, the racing line and the surface. It is normally a baked file mapped straight into memory, so loading
+ * is a validation of the header and nothing else, and every process using the track shares the
+ * same pages. A track baked at runtime can be handed over as a buffer instead
+ */
+class TrackAsset
+{
+public:
+	TrackAsset();
+
+	// Non-copyable, the views point into memory this object owns
+	TrackAsset(const TrackAsset& other) = delete;
+	TrackAsset& operator=(const TrackAsset& other) = delete;
+
+	/**
+	 * \brief Maps a baked track file
+	 * \param path The file to map
+	 * \return True if the file exists and is a valid track of the current version
+	 */
+	bool LoadFromFile(const std::string& path);
+
+	/**
+	 * \brief Uses a track that was baked in memory
+	 * \param asset The baked bytes, laid out the same as a track file
+	 * \return True if the bytes are a valid track
+	 */
+	bool LoadFromMemory(std::vector<uint8_t> asset);
+
+	/**
+	 * \return The amount of checkpoints around the track
+	 */
+	[[nodiscard]] int CheckPointCount() const { return static_cast<int>(m_header->checkPointCount); }
+
+	/**
+	 * \param checkPoint The index of the checkpoint, 0 being the finish line
+	 * \return The checkpoint
+	 */
+	[[nodiscard]] const track_format::CheckPoint& GetCheckPoint(const int checkPoint) const { return m_checkPoints[checkPoint]; }
+
+	/**
+	 * \return The amount of places on the starting grid
+	 */
+	[[nodiscard]] int SpawnPointCount() const { return static_cast<int>(m_header->spawnPointCount); }
+
+	/**
+	 * \param spawnPoint The index of the place on the starting grid
+	 * \return Where a car starts from
+	 */
+	[[nodiscard]] sf::Vector2f GetSpawnPoint(const int spawnPoint) const { return m_spawnPoints[spawnPoint].position; }
+
+	/**
+	 * \return The line around the middle of the track
+	 */
+	[[nodiscard]] const TrackCentreline& Centreline() const { return m_centreline; }
+
+	/**
+	 * \return The amount of waypoints on the racing line
+	 */
+	[[nodiscard]] int RacingLinePointCount() const { return static_cast<int>(m_header->racingLinePointCount); }
+
+	/**
+	 * \param waypoint The index of the waypoint, the line loops back round to 0 after the last one
+	 * \return The waypoint
+	 */
+	[[nodiscard]] const track_format::RacingLinePoint& GetRacingLinePoint(const int waypoint) const { return m_racingLine[waypoint]; }
+
+	/**
+	 * \return The distance between neighbouring waypoints on the racing line
+	 */
+	[[nodiscard]] float RacingLineSpacing() const { return m_header->racingLineSpacing; }
+
+	/**
+	 * \return Which parts of the map are track and which are grass
+	 */
+	[[nodiscard]] const SurfaceMask& Surface() const { return m_surface; }
+
+private:
+	// The file the track was mapped from, if it came from a file
+	MappedFile m_file;
+
+	// The bytes of the track, if it was baked in memory
+	std::vector<uint8_t> m_bakedAsset;
+
+	// Views into whichever of the two holds the track
+	const track_format::Header* m_header;
+	const track_format::CheckPoint* m_checkPoints;
+	const track_format::SpawnPoint* m_spawnPoints;
+	TrackCentreline m_centreline;
+	const track_format::RacingLinePoint* m_racingLine;
+	SurfaceMask m_surface;
+
+	/**
+	 * \brief Checks that the bytes are a valid track and points the views into them
+	 * \param data The start of the track
+	 * \param size The size of the track in bytes
+	 * \return True if the track is valid
+	 */
+	bool Attach(const uint8_t* data, size_t size);
+
+	/**
+	 * \brief Points the views back at an empty track, before the memory they use goes away
+	 */
+	void Detach();
+};
@@ -0,0 +1,597 @@
+#include "TrackBake.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <SFML/Graphics/Image.hpp>
+
+#include "Logger.h"
+#include "SurfaceMask.h"
+#include "TrackAsset.h"
+#include "../NMG ICA/Globals.h"
+
+namespace
+{
+	// The racing line has a waypoint roughly this many pixels apart
+	constexpr float RACING_LINE_SPACING = 8.f;
+
+	// How close the racing line is allowed to get to the grass, a little over half a car
+	constexpr float RACING_LINE_MARGIN = 12.f;
+
+	// How many times the racing line is pulled tighter, and how often it is evened back out
+	constexpr int RACING_LINE_PASSES = 600;
+	constexpr int RACING_LINE_RESAMPLE_INTERVAL = 50;
+
+	// The tightness of a corner is measured between the waypoints this far either side
+	constexpr int CORNER_SPAN = 3;
+
+	// How far before a corner the racing line slows down for it
+	constexpr float BRAKING_DISTANCE = 64.f;
+
+	// Directions around a point, used to check it is clear of the grass
+	constexpr float MARGIN_DIRECTIONS[8][2]{
+		{ 1.f, 0.f },
+		{ 0.7071068f, 0.7071068f },
+		{ 0.f, 1.f },
+		{ -0.7071068f, 0.7071068f },
+		{ -1.f, 0.f },
+		{ -0.7071068f, -0.7071068f },
+		{ 0.f, -1.f },
+		{ 0.7071068f, -0.7071068f }
+	};
+
+	/**
+	 * \param a A point
+	 * \param b Another point
+	 * \return The distance between the two points
+	 */
+	float distance_between(const sf::Vector2f& a, const sf::Vector2f& b)
+	{
+		const sf::Vector2f difference = b - a;
+		return std::sqrt(difference.x * difference.x + difference.y * difference.y);
+	}
+
+	/**
+	 * \param points The corners of a closed loop
+	 * \return The distance around the loop
+	 */
+	float loop_length(const std::vector<sf::Vector2f>& points)
+	{
+		float length = 0.f;
+		for (size_t i = 0; i < points.size(); ++i)
+		{
+			length += distance_between(points[i], points[(i + 1) % points.size()]);
+		}
+		return length;
+	}
+
+	/**
+	 * \brief Spreads points evenly around a closed loop
+	 * \param corners The corners of the loop, the first stays where it is
+	 * \param spacing Roughly how far apart the new points should be
+	 * \return The new points, all exactly the same distance apart along the loop
+	 */
+	std::vector<sf::Vector2f> resample_loop(const std::vector<sf::Vector2f>& corners, const float spacing)
+	{
+		const float length = loop_length(corners);
+		const int count = std::max(3, static_cast<int>(std::lround(length / spacing)));
+		const float step = length / static_cast<float>(count);
+
+		std::vector<sf::Vector2f> points;
+		points.reserve(count);
+
+		size_t corner = 0;
+		float segmentStart = 0.f;
+		float segmentLength = distance_between(corners[0], corners[1 % corners.size()]);
+
+		for (int i = 0; i < count; ++i)
+		{
+			const float distance = static_cast<float>(i) * step;
+
+			// Walk on to the segment the distance falls in
+			while (distance > segmentStart + segmentLength && corner + 1 < corners.size())
+			{
+				segmentStart += segmentLength;
+				++corner;
+				segmentLength = distance_between(corners[corner], corners[(corner + 1) % corners.size()]);
+			}
+
+			const sf::Vector2f& from = corners[corner];
+			const sf::Vector2f& to = corners[(corner + 1) % corners.size()];
+			const float t = segmentLength > 0.f ? (distance - segmentStart) / segmentLength : 0.f;
+
+			points.emplace_back(from + (to - from) * t);
+		}
+
+		return points;
+	}
+
+	/**
+	 * \param surface The track surface
+	 * \param position A position on the map
+	 * \return True if everything within RACING_LINE_MARGIN of the position is track
+	 */
+	bool clear_of_grass(const SurfaceMask& surface, const sf::Vector2f& position)
+	{
+		if (surface.At(position) != eSurfaceType::e_Track)
+		{
+			return false;
+		}
+
+		for (const auto& direction : MARGIN_DIRECTIONS)
+		{
+			if (surface.At(position + sf::Vector2f(direction[0], direction[1]) * RACING_LINE_MARGIN) != eSurfaceType::e_Track)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * \brief Finds the shortest way along the track between two gates, moving between neighbouring
+	 * pixels that are clear of the grass
+	 * \param clear One byte per pixel, non-zero where a waypoint is allowed
+	 * \param width The width of the map
+	 * \param height The height of the map
+	 * \param from The pixel to start from
+	 * \param to The pixel to finish at
+	 * \param path Has the pixels along the way appended to it, not including the finish
+	 * \return True if there is a way through
+	 */
+	bool find_path(const std::vector<uint8_t>& clear, const int width, const int height, const sf::Vector2i& from, const sf::Vector2i& to, std::vector<sf::Vector2f>& path)
+	{
+		constexpr int NEIGHBOURS[8][2]{ { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }, { 1, 1 }, { -1, 1 }, { 1, -1 }, { -1, -1 } };
+
+		const int start = from.y * width + from.x;
+		const int finish = to.y * width + to.x;
+
+		// A breadth first search, remembering where each pixel was reached from
+		std::vector<int> cameFrom(clear.size(), -1);
+		std::vector<int> frontier{ start };
+		cameFrom[start] = start;
+
+		for (size_t next = 0; next < frontier.size() && cameFrom[finish] < 0; ++next)
+		{
+			const int x = frontier[next] % width;
+			const int y = frontier[next] / width;
+
+			for (const auto& neighbour : NEIGHBOURS)
+			{
+				const int nx = x + neighbour[0];
+				const int ny = y + neighbour[1];
+				if (nx < 0 || ny < 0 || nx >= width || ny >= height)
+				{
+					continue;
+				}
+
+				const int pixel = ny * width + nx;
+				if (cameFrom[pixel] < 0 && (clear[pixel] || pixel == finish))
+				{
+					cameFrom[pixel] = frontier[next];
+					frontier.push_back(pixel);
+				}
+			}
+		}
+
+		if (cameFrom[finish] < 0)
+		{
+			return false;
+		}
+
+		// Walk back from the finish and then turn the pixels round into driving order
+		const size_t firstPixel = path.size();
+		for (int pixel = cameFrom[finish]; ; pixel = cameFrom[pixel])
+		{
+			path.emplace_back(static_cast<float>(pixel % width) + 0.5f, static_cast<float>(pixel / width) + 0.5f);
+			if (pixel == start)
+			{
+				break;
+			}
+		}
+		std::reverse(path.begin() + static_cast<std::ptrdiff_t>(firstPixel), path.end());
+
+		return true;
+	}
+
+	/**
+	 * \brief Works out a racing line. A path is found through every gate in turn, and then pulled
+	 * tight like a piece of string: each pass moves every waypoint towards the middle of its
+	 * neighbours, which straightens the line and cuts across the inside of the corners, but never
+	 * closer to the grass than RACING_LINE_MARGIN
+	 * \param checkPoints The checkpoints in driving order
+	 * \param surface The track surface
+	 * \param line Filled with the waypoints of the racing line, evenly spaced
+	 * \return False if there is no way round the track that keeps clear of the grass
+	 */
+	bool pull_racing_line(const std::vector<track_format::CheckPoint>& checkPoints, const SurfaceMask& surface, std::vector<sf::Vector2f>& line)
+	{
+		const int width = surface.Width();
+		const int height = surface.Height();
+
+		std::vector<uint8_t> clear(static_cast<size_t>(width) * height);
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				clear[y * width + x] = clear_of_grass(surface, { static_cast<float>(x) + 0.5f, static_cast<float>(y) + 0.5f });
+			}
+		}
+
+		// The middle of each gate as a pixel
+		std::vector<sf::Vector2i> gateMiddles;
+		for (const auto& checkPoint : checkPoints)
+		{
+			const sf::Vector2f middle = (checkPoint.gateStart + checkPoint.gateEnd) / 2.f;
+			gateMiddles.emplace_back(
+				std::clamp(static_cast<int>(middle.x), 0, width - 1),
+				std::clamp(static_cast<int>(middle.y), 0, height - 1)
+			);
+		}
+
+		std::vector<sf::Vector2f> corners;
+		for (size_t gate = 0; gate < checkPoints.size(); ++gate)
+		{
+			const size_t nextGate = (gate + 1) % checkPoints.size();
+
+			// Close every other gate so the path can't sneak the wrong way round the track
+			std::vector<uint8_t> open = clear;
+			for (size_t other = 0; other < checkPoints.size(); ++other)
+			{
+				if (other == gate || other == nextGate)
+				{
+					continue;
+				}
+
+				const sf::Vector2f& gateStart = checkPoints[other].gateStart;
+				const sf::Vector2f& gateEnd = checkPoints[other].gateEnd;
+				const int samples = static_cast<int>(distance_between(gateStart, gateEnd) * 2.f) + 1;
+
+				for (int sample = 0; sample <= samples; ++sample)
+				{
+					const sf::Vector2f point = gateStart + (gateEnd - gateStart) * (static_cast<float>(sample) / static_cast<float>(samples));
+					const int x = static_cast<int>(point.x);
+					const int y = static_cast<int>(point.y);
+					if (x >= 0 && y >= 0 && x < width && y < height)
+					{
+						open[y * width + x] = 0;
+					}
+				}
+			}
+
+			if (!find_path(open, width, height, gateMiddles[gate], gateMiddles[nextGate], corners))
+			{
+				return false;
+			}
+		}
+
+		line = resample_loop(corners, RACING_LINE_SPACING);
+
+		for (int pass = 1; pass <= RACING_LINE_PASSES; ++pass)
+		{
+			for (size_t i = 0; i < line.size(); ++i)
+			{
+				const sf::Vector2f& previous = line[(i + line.size() - 1) % line.size()];
+				const sf::Vector2f& next = line[(i + 1) % line.size()];
+				const sf::Vector2f moved = line[i] + ((previous + next) / 2.f - line[i]) * 0.5f;
+
+				if (clear_of_grass(surface, moved))
+				{
+					line[i] = moved;
+				}
+			}
+
+			// Pulling bunches the waypoints up around the corners, so spread them back out now and again
+			if (pass % RACING_LINE_RESAMPLE_INTERVAL == 0)
+			{
+				line = resample_loop(line, RACING_LINE_SPACING);
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * \brief Works out how fast each waypoint can be taken. The cars turn at a fixed rate, so a corner
+	 * of radius r can be driven at k_carTurnSpeed * r at most, and each waypoint is held to the slowest
+	 * corner within BRAKING_DISTANCE ahead of it
+	 * \param line The evenly spaced waypoints of the racing line
+	 * \param spacing The distance between neighbouring waypoints
+	 * \return The racing line with its target speeds
+	 */
+	std::vector<track_format::RacingLinePoint> add_target_speeds(const std::vector<sf::Vector2f>& line, const float spacing)
+	{
+		const int count = static_cast<int>(line.size());
+
+		// The radius of the circle through a waypoint and the waypoints either side of it
+		std::vector<float> cornerSpeeds(count);
+		for (int i = 0; i < count; ++i)
+		{
+			const sf::Vector2f& a = line[(i + count - CORNER_SPAN) % count];
+			const sf::Vector2f& b = line[i];
+			const sf::Vector2f& c = line[(i + CORNER_SPAN) % count];
+
+			const float twiceArea = std::abs((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x));
+			const float sides = distance_between(a, b) * distance_between(b, c) * distance_between(c, a);
+
+			cornerSpeeds[i] = globals::cars::k_carTrackSpeed;
+			if (twiceArea > 0.f)
+			{
+				const float radius = sides / (2.f * twiceArea);
+				cornerSpeeds[i] = std::min(globals::cars::k_carTrackSpeed, globals::cars::k_carTurnSpeed * radius);
+			}
+		}
+
+		const int brakingWaypoints = std::min(count, static_cast<int>(std::ceil(BRAKING_DISTANCE / spacing)));
+
+		std::vector<track_format::RacingLinePoint> racingLine(count);
+		for (int i = 0; i < count; ++i)
+		{
+			float targetSpeed = cornerSpeeds[i];
+			for (int ahead = 1; ahead <= brakingWaypoints; ++ahead)
+			{
+				targetSpeed = std::min(targetSpeed, cornerSpeeds[(i + ahead) % count]);
+			}
+
+			racingLine[i] = { line[i], targetSpeed };
+		}
+
+		return racingLine;
+	}
+
+	/**
+	 * \param offset An offset into the file
+	 * \return The offset rounded up so the next section is 4 byte aligned
+	 */
+	uint32_t align_section(const size_t offset)
+	{
+		return static_cast<uint32_t>((offset + 3) & ~static_cast<size_t>(3));
+	}
+
+	/**
+	 * \brief Works out the gate of a checkpoint, the line down the middle of its longest side
+	 * \param bounds The rectangle of the checkpoint
+	 * \return The checkpoint with its gate
+	 */
+	track_format::CheckPoint make_check_point(const sf::FloatRect& bounds)
+	{
+		track_format::CheckPoint checkPoint{ bounds, {}, {} };
+
+		if (bounds.height >= bounds.width)
+		{
+			const float middle = bounds.left + bounds.width / 2.f;
+			checkPoint.gateStart = { middle, bounds.top };
+			checkPoint.gateEnd = { middle, bounds.top + bounds.height };
+		}
+		else
+		{
+			const float middle = bounds.top + bounds.height / 2.f;
+			checkPoint.gateStart = { bounds.left, middle };
+			checkPoint.gateEnd = { bounds.left + bounds.width, middle };
+		}
+
+		return checkPoint;
+	}
+
+	/**
+	 * \brief Copies an array into the baked track
+	 * \param asset The baked track
+	 * \param offset Where the array goes
+	 * \param elements The array to copy
+	 */
+	template<typename T>
+	void write_section(std::vector<uint8_t>& asset, const uint32_t offset, const std::vector<T>& elements)
+	{
+		if (!elements.empty())
+		{
+			std::memcpy(asset.data() + offset, elements.data(), elements.size() * sizeof(T));
+		}
+	}
+} // anonymous namespace
+
+namespace track_bake
+{
+	bool load_description(const std::string& path, TrackDescription& description)
+	{
+		std::ifstream file(path);
+		if (!file)
+		{
+			return false;
+		}
+
+		description = {};
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			std::istringstream words(line);
+
+			std::string kind;
+			if (!(words >> kind) || kind[0] == '#')
+			{
+				continue;
+			}
+
+			if (kind == "checkpoint")
+			{
+				sf::FloatRect bounds;
+				if (!(words >> bounds.left >> bounds.top >> bounds.width >> bounds.height))
+				{
+					return false;
+				}
+				description.checkPoints.emplace_back(bounds);
+			}
+			else if (kind == "spawn")
+			{
+				sf::Vector2f position;
+				if (!(words >> position.x >> position.y))
+				{
+					return false;
+				}
+				description.spawnPoints.emplace_back(position);
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		return description.checkPoints.size() >= 2 && !description.spawnPoints.empty();
+	}
+
+	std::vector<uint8_t> bake(const TrackDescription& description, const sf::Image& image)
+	{
+		// The checkpoints and their gates
+		std::vector<track_format::CheckPoint> checkPoints;
+		for (const auto& bounds : description.checkPoints)
+		{
+			checkPoints.emplace_back(make_check_point(bounds));
+		}
+
+		// The starting grid
+		std::vector<track_format::SpawnPoint> spawnPoints;
+		for (const auto& position : description.spawnPoints)
+		{
+			spawnPoints.push_back({ position });
+		}
+
+		// The centreline joins up the middle of each gate, starting from the finish line
+		std::vector<track_format::CentrelinePoint> centreline(checkPoints.size());
+		float trackLength = 0.f;
+
+		for (size_t i = 0; i < checkPoints.size(); ++i)
+		{
+			const auto& from = checkPoints[i];
+			const auto& to = checkPoints[(i + 1) % checkPoints.size()];
+
+			const sf::Vector2f start = (from.gateStart + from.gateEnd) / 2.f;
+			const sf::Vector2f difference = (to.gateStart + to.gateEnd) / 2.f - start;
+			const float length = std::sqrt(difference.x * difference.x + difference.y * difference.y);
+
+			centreline[i].position = start;
+			centreline[i].direction = length > 0.f ? difference / length : sf::Vector2f(0.f, 0.f);
+			centreline[i].segmentLength = length;
+			centreline[i].distanceAlong = trackLength;
+
+			trackLength += length;
+		}
+
+		// The surface, one bit per pixel set where the pixel is track
+		const int width = static_cast<int>(image.getSize().x);
+		const int height = static_cast<int>(image.getSize().y);
+		const int wordsPerRow = SurfaceMask::WordsPerRow(width);
+
+		std::vector<uint32_t> surface(static_cast<size_t>(wordsPerRow) * height, 0u);
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				const sf::Color pixel = image.getPixel(static_cast<unsigned>(x), static_cast<unsigned>(y));
+				if (pixel == sf::Color::Black || pixel == sf::Color::White)
+				{
+					surface[y * wordsPerRow + (x >> 5)] |= 1u << (x & 31);
+				}
+			}
+		}
+
+		// The racing line for the AI. If the track is too narrow for one, the AI falls back to the centreline
+		std::vector<sf::Vector2f> pulledLine;
+		if (!pull_racing_line(checkPoints, SurfaceMask(width, height, surface.data()), pulledLine))
+		{
+			LOG_WARNING("There is no racing line that keeps clear of the grass, using the centreline instead");
+
+			std::vector<sf::Vector2f> corners;
+			for (const auto& point : centreline)
+			{
+				corners.emplace_back(point.position);
+			}
+			pulledLine = resample_loop(corners, RACING_LINE_SPACING);
+		}
+
+		const float racingLineSpacing = loop_length(pulledLine) / static_cast<float>(pulledLine.size());
+		const std::vector<track_format::RacingLinePoint> racingLine = add_target_speeds(pulledLine, racingLineSpacing);
+
+		// Lay the sections out one after the other
+		track_format::Header header{};
+		header.magic = track_format::k_magic;
+		header.version = track_format::k_version;
+
+		header.checkPointCount = static_cast<uint32_t>(checkPoints.size());
+		header.checkPointsOffset = align_section(sizeof(header));
+
+		header.spawnPointCount = static_cast<uint32_t>(spawnPoints.size());
+		header.spawnPointsOffset = align_section(header.checkPointsOffset + checkPoints.size() * sizeof(track_format::CheckPoint));
+
+		header.centrelinePointCount = static_cast<uint32_t>(centreline.size());
+		header.centrelinePointsOffset = align_section(header.spawnPointsOffset + spawnPoints.size() * sizeof(track_format::SpawnPoint));
+		header.trackLength = trackLength;
+
+		header.racingLinePointCount = static_cast<uint32_t>(racingLine.size());
+		header.racingLinePointsOffset = align_section(header.centrelinePointsOffset + centreline.size() * sizeof(track_format::CentrelinePoint));
+		header.racingLineSpacing = racingLineSpacing;
+
+		header.surfaceWidth = static_cast<uint32_t>(width);
+		header.surfaceHeight = static_cast<uint32_t>(height);
+		header.surfaceOffset = align_section(header.racingLinePointsOffset + racingLine.size() * sizeof(track_format::RacingLinePoint));
+
+		header.fileSize = static_cast<uint32_t>(header.surfaceOffset + surface.size() * sizeof(uint32_t));
+
+		std::vector<uint8_t> asset(header.fileSize, 0);
+		std::memcpy(asset.data(), &header, sizeof(header));
+		write_section(asset, header.checkPointsOffset, checkPoints);
+		write_section(asset, header.spawnPointsOffset, spawnPoints);
+		write_section(asset, header.centrelinePointsOffset, centreline);
+		write_section(asset, header.racingLinePointsOffset, racingLine);
+		write_section(asset, header.surfaceOffset, surface);
+
+		return asset;
+	}
+
+	bool save(const std::string& path, const std::vector<uint8_t>& asset)
+	{
+		std::ofstream file(path, std::ios::binary);
+		if (!file)
+		{
+			return false;
+		}
+
+		file.write(reinterpret_cast<const char*>(asset.data()), static_cast<std::streamsize>(asset.size()));
+		return static_cast<bool>(file);
+	}
+
+	bool load_or_bake(TrackAsset& track, const std::string& assetPath, const std::string& descriptionPath, const std::string& imagePath)
+	{
+		if (track.LoadFromFile(assetPath))
+		{
+			return true;
+		}
+
+		LOG_WARNING("There is no up to date baked track at {}, baking it now", assetPath);
+
+		TrackDescription description;
+		if (!load_description(descriptionPath, description))
+		{
+			LOG_ERROR("Unable to read the track description {}", descriptionPath);
+			return false;
+		}
+
+		sf::Image image;
+		if (!image.loadFromFile(imagePath))
+		{
+			LOG_ERROR("Unable to load the map image {}", imagePath);
+			return false;
+		}
+
+		std::vector<uint8_t> asset = bake(description, image);
+
+		if (!save(assetPath, asset))
+		{
+			LOG_WARNING("Unable to save the baked track to {}", assetPath);
+		}
+
+		return track.LoadFromMemory(std::move(asset));
+	}
+} // namespace track_bake
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+
+class TrackAsset;
+
+namespace sf
+{
+	class Image;
+}
+
+/**
+ * \brief Turns a track description and the map image into a baked track, the layout described in
+ * TrackFormat.h. Used by the TrackBaker tool, and by the game when there is no baked file to load
+ */
+namespace track_bake
+{
+	/**
+	 * \brief The hand written parts of a track, loaded from a text file
+	 */
+	struct TrackDescription
+	{
+		// The checkpoints in driving order, the first is the finish line
+		std::vector<sf::FloatRect> checkPoints;
+
+		// The starting grid
+		std::vector<sf::Vector2f> spawnPoints;
+	};
+
+	/**
+	 * \brief Reads a track description. Each line is either a comment starting with #,
+	 * "checkpoint left top width height" or "spawn x y"
+	 * \param path The file to read
+	 * \param description Filled with the track
+	 * \return True if the file was read and every line made sense
+	 */
+	bool load_description(const std::string& path, TrackDescription& description);
+
+	/**
+	 * \brief Bakes a track
+	 * \param description The checkpoints and starting grid
+	 * \param image The map image, the black and white pixels are the track and everything else is grass
+	 * \return The baked track, ready to be saved or loaded
+	 */
+	std::vector<uint8_t> bake(const TrackDescription& description, const sf::Image& image);
+
+	/**
+	 * \brief Writes a baked track to a file
+	 * \param path The file to write
+	 * \param asset The baked track
+	 * \return True if the file was written
+	 */
+	bool save(const std::string& path, const std::vector<uint8_t>& asset);
+
+	/**
+	 * \brief Loads the baked track if there is one, otherwise bakes it from the description and the
+	 * image and tries to save it for next time
+	 * \param track The track to load into
+	 * \param assetPath The baked track file
+	 * \param descriptionPath The track description to bake from
+	 * \param imagePath The map image to bake from
+	 * \return True if the track was loaded or baked
+	 */
+	bool load_or_bake(TrackAsset& track, const std::string& assetPath, const std::string& descriptionPath, const std::string& imagePath);
+} // namespace track_bake
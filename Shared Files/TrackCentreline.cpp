@@ -0,0 +1,70 @@
+#include "TrackCentreline.h"
+
+#include <algorithm>
+#include <string>
+
+#include "../NMG ICA/Globals.h"
+
+TrackCentreline::TrackCentreline() :
+	m_points(nullptr),
+	m_count(0),
+	m_length(0.f)
+{
+}
+
+TrackCentreline::TrackCentreline(const track_format::CentrelinePoint* points, const int count, const float length) :
+	m_points(points),
+	m_count(count),
+	m_length(length)
+{
+}
+
+float TrackCentreline::DistanceAlong(const sf::Vector2f& position, int& segmentHint) const
+{
+	const int segmentCount = SegmentCount();
+
+	int best = std::clamp(segmentHint, 0, segmentCount - 1);
+	float bestAlong;
+	float bestDistance = ProjectOntoSegment(best, position, bestAlong);
+
+	// Walk forwards while the next segment is nearer, and if that didn't move, walk backwards.
+	// Cars only move a little between updates so this normally stops after a step or two
+	for (const int step : { 1, segmentCount - 1 })
+	{
+		const int start = best;
+
+		for (int walked = 0; walked < segmentCount; ++walked)
+		{
+			const int candidate = (best + step) % segmentCount;
+
+			float along;
+			const float distance = ProjectOntoSegment(candidate, position, along);
+			if (distance >= bestDistance)
+			{
+				break;
+			}
+
+			best = candidate;
+			bestAlong = along;
+			bestDistance = distance;
+		}
+
+		if (best != start)
+		{
+			break;
+		}
+	}
+
+	segmentHint = best;
+	return m_points[best].distanceAlong + bestAlong;
+}
+
+float TrackCentreline::ProjectOntoSegment(const int segment, const sf::Vector2f& position, float& along) const
+{
+	const track_format::CentrelinePoint& point = m_points[segment];
+	const sf::Vector2f fromStart = position - point.position;
+
+	along = std::clamp(fromStart.x * point.direction.x + fromStart.y * point.direction.y, 0.f, point.segmentLength);
+
+	return globals::sqr_magnitude(fromStart - point.direction * along);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+
+#include "TrackFormat.h"
+
+/**
+ * \brief A closed polyline that runs around the middle of the track. Any position can be turned
+ * into how far along the track it is, which gives a single number to rank the cars with. Each car
+ * keeps the segment it was last nearest to as a hint, and the search walks out from there, so
+ * looking up a car that has moved a little costs O(1). The points are baked into the track asset
+ * and used in place
+ */
+class TrackCentreline
+{
+public:
+	/**
+	 * \brief An empty centreline, it has to be assigned a real one before it is used
+	 */
+	TrackCentreline();
+
+	/**
+	 * \param points The corners of the polyline in driving order, they must outlive the centreline.
+	 * The last point joins back up with the first, and the first point is where the distance along
+	 * the track is 0
+	 * \param count The amount of points
+	 * \param length The distance around the whole track
+	 */
+	TrackCentreline(const track_format::CentrelinePoint* points, int count, float length);
+
+	/**
+	 * \return The distance around the whole track
+	 */
+	[[nodiscard]] float Length() const { return m_length; }
+
+	/**
+	 * \return The amount of segments in the polyline
+	 */
+	[[nodiscard]] int SegmentCount() const { return m_count; }
+
+	/**
+	 * \brief Finds the nearest point on the centreline to a position
+	 * \param position The position to look up
+	 * \param segmentHint The segment the position was nearest last time, updated with the
+	 * segment it is nearest now
+	 * \return How far along the track the nearest point is, between 0 and Length()
+	 */
+	float DistanceAlong(const sf::Vector2f& position, int& segmentHint) const;
+
+private:
+	// The corners of the polyline
+	const track_format::CentrelinePoint* m_points;
+	int m_count;
+
+	// The distance around the whole track
+	float m_length;
+
+	/**
+	 * \brief Projects a position onto a single segment
+	 * \param segment The index of the segment
+	 * \param position The position to project
+	 * \param along Set to how far along the segment the nearest point is
+	 * \return The squared distance from the position to the nearest point on the segment
+	 */
+	float ProjectOntoSegment(int segment, const sf::Vector2f& position, float& along) const;
+};
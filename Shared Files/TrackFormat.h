@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+
+/**
+ * \brief The layout of a baked track file. The file starts with a Header and every section after it
+ * is an array of one of the structs below, 4 byte aligned, at the offset the header gives. Nothing
+ * needs parsing, the arrays are used in place straight out of the mapped file. Everything is stored
+ * little-endian, the same as every platform the game runs on
+ */
+namespace track_format
+{
+	// The first bytes of a track file, "NMGT"
+	constexpr uint32_t k_magic = 0x54474D4Eu;
+
+	// Bumped whenever the layout changes, files with any other version are rebaked
+	constexpr uint32_t k_version = 2u;
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+
+		// The size of the whole file, to catch files that were cut short
+		uint32_t fileSize;
+
+		uint32_t checkPointCount;
+		uint32_t checkPointsOffset;
+
+		uint32_t spawnPointCount;
+		uint32_t spawnPointsOffset;
+
+		// The centreline has one point per checkpoint, through the middle of its gate
+		uint32_t centrelinePointCount;
+		uint32_t centrelinePointsOffset;
+		float trackLength;
+
+		// The racing line for the AI, with a waypoint every racingLineSpacing pixels
+		uint32_t racingLinePointCount;
+		uint32_t racingLinePointsOffset;
+		float racingLineSpacing;
+
+		// The surface mask, SurfaceMask::WordsPerRow(surfaceWidth) * surfaceHeight words
+		uint32_t surfaceWidth;
+		uint32_t surfaceHeight;
+		uint32_t surfaceOffset;
+	};
+
+	/**
+	 * \brief A checkpoint, in driving order with the finish line first. The gate is the line down
+	 * the middle of the rectangle along its longest side, which the cars have to cross
+	 */
+	struct CheckPoint
+	{
+		sf::FloatRect bounds;
+		sf::Vector2f gateStart;
+		sf::Vector2f gateEnd;
+	};
+
+	/**
+	 * \brief A place on the grid where a car starts the race
+	 */
+	struct SpawnPoint
+	{
+		sf::Vector2f position;
+	};
+
+	/**
+	 * \brief A corner of the track centreline, along with the segment that leaves it
+	 */
+	struct CentrelinePoint
+	{
+		sf::Vector2f position;
+
+		// The unit direction and length of the segment to the next point
+		sf::Vector2f direction;
+		float segmentLength;
+
+		// How far around the track this point is from the finish line
+		float distanceAlong;
+	};
+
+	/**
+	 * \brief A waypoint on the racing line, in driving order
+	 */
+	struct RacingLinePoint
+	{
+		sf::Vector2f position;
+
+		// The fastest a car can go from here and still make the corners coming up
+		float targetSpeed;
+	};
+
+	static_assert(std::is_trivially_copyable_v<sf::FloatRect> && sizeof(sf::FloatRect) == 16, "The file layout needs FloatRect to be four floats");
+	static_assert(std::is_trivially_copyable_v<sf::Vector2f> && sizeof(sf::Vector2f) == 8, "The file layout needs Vector2f to be two floats");
+	static_assert(sizeof(Header) == 64, "The header layout has changed, bump k_version");
+	static_assert(sizeof(CheckPoint) == 32, "The checkpoint layout has changed, bump k_version");
+	static_assert(sizeof(CentrelinePoint) == 24, "The centreline layout has changed, bump k_version");
+	static_assert(sizeof(RacingLinePoint) == 12, "The racing line layout has changed, bump k_version");
+} // namespace track_format
@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <SFML/Network/Packet.hpp>
+
+/**
+ * \brief Everything a spectator, or a player resuming their session, needs to know about one car
+ */
+struct WorldCar
+{
+	uint16_t networkId = 0;
+	std::string username;
+	float x = 0.f;
+	float y = 0.f;
+	float angle = 0.f;
+	uint8_t red = 0;
+	uint8_t green = 0;
+	uint8_t blue = 0;
+	uint8_t lapsCompleted = 0;
+};
+
+/**
+ * \brief A keyframe of the whole race. Spectators start from one when they join and the server sends
+ * them now and then, so a spectator that fell behind or missed a message catches up again. Between
+ * keyframes spectators follow the same messages the players receive. A player who resumes their
+ * session after a dropped connection is brought up to date with one as well
+ */
+struct WorldSnapshot
+{
+	bool gameStarted = false;
+	bool gameOver = false;
+
+	std::vector<WorldCar> cars;
+
+	// The usernames from first place to last, once the game is over
+	std::vector<std::string> placementOrder;
+
+	/**
+	 * \param networkId The network ID of the car to look for
+	 * \return The car, or nullptr if there isn't one with the network ID
+	 */
+	WorldCar* FindCar(const uint16_t networkId)
+	{
+		for (auto& car : cars)
+		{
+			if (car.networkId == networkId)
+			{
+				return &car;
+			}
+		}
+		return nullptr;
+	}
+};
+
+inline sf::Packet& operator<<(sf::Packet& packet, const WorldCar& car)
+{
+	return packet << car.networkId << car.username << car.x << car.y << car.angle << car.red << car.green << car.blue << car.lapsCompleted;
+}
+
+inline sf::Packet& operator>>(sf::Packet& packet, WorldCar& car)
+{
+	return packet >> car.networkId >> car.username >> car.x >> car.y >> car.angle >> car.red >> car.green >> car.blue >> car.lapsCompleted;
+}
+
+inline sf::Packet& operator<<(sf::Packet& packet, const WorldSnapshot& world)
+{
+	packet << world.gameStarted << world.gameOver;
+
+	packet << static_cast<uint16_t>(world.cars.size());
+	for (const auto& car : world.cars)
+	{
+		packet << car;
+	}
+
+	packet << static_cast<uint16_t>(world.placementOrder.size());
+	for (const auto& username : world.placementOrder)
+	{
+		packet << username;
+	}
+
+	return packet;
+}
+
+inline sf::Packet& operator>>(sf::Packet& packet, WorldSnapshot& world)
+{
+	packet >> world.gameStarted >> world.gameOver;
+
+	uint16_t carCount = 0;
+	packet >> carCount;
+	world.cars.resize(carCount);
+	for (auto& car : world.cars)
+	{
+		packet >> car;
+	}
+
+	uint16_t placementCount = 0;
+	packet >> placementCount;
+	world.placementOrder.resize(placementCount);
+	for (auto& username : world.placementOrder)
+	{
+		packet >> username;
+	}
+
+	return packet;
+}
@@ -0,0 +1,42 @@
+#include <iostream>
+#include <string>
+#include <SFML/Graphics/Image.hpp>
+
+#include "../Shared Files/TrackBake.h"
+
+/**
+ * \brief Bakes a track description and map image into the track file the game maps at startup.
+ * Usage: TrackBaker [description] [image] [output], the game's track is baked if they are left out
+ */
+int main(const int argc, char* argv[])
+{
+	const std::string descriptionPath = argc > 1 ? argv[1] : "../NMG ICA/images/map_track.txt";
+	const std::string imagePath = argc > 2 ? argv[2] : "../NMG ICA/images/map.png";
+	const std::string outputPath = argc > 3 ? argv[3] : "../NMG ICA/images/map.track";
+
+	track_bake::TrackDescription description;
+	if (!track_bake::load_description(descriptionPath, description))
+	{
+		std::cout << "Unable to read the track description " << descriptionPath << std::endl;
+		return 1;
+	}
+
+	sf::Image image;
+	if (!image.loadFromFile(imagePath))
+	{
+		std::cout << "Unable to load the map image " << imagePath << std::endl;
+		return 1;
+	}
+
+	const auto asset = track_bake::bake(description, image);
+
+	if (!track_bake::save(outputPath, asset))
+	{
+		std::cout << "Unable to write the baked track to " << outputPath << std::endl;
+		return 1;
+	}
+
+	std::cout << "Baked " << description.checkPoints.size() << " checkpoints and " << description.spawnPoints.size()
+		<< " starting places into " << outputPath << " (" << asset.size() << " bytes)" << std::endl;
+	return 0;
+}